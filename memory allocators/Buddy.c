@@ -0,0 +1,239 @@
+#include "Buddy.h"
+
+// bitmap helpers. _node_ is the index of a node in the tree, where level l holds
+// nodes (2^l - 1) through (2^(l+1) - 2), and the children of node n are 2n + 1 and 2n + 2
+
+static int buddy_bit_get(const uint8_t* p_bits, const size_t node) {
+	return (p_bits[node >> 3] >> (node & 7)) & 1;
+}
+
+static void buddy_bit_set(uint8_t* p_bits, const size_t node) {
+	p_bits[node >> 3] |= (uint8_t)(1 << (node & 7));
+}
+
+static void buddy_bit_clear(uint8_t* p_bits, const size_t node) {
+	p_bits[node >> 3] &= (uint8_t)~(1 << (node & 7));
+}
+
+// returns the node of the block at _p_block_ on _level_
+static size_t buddy_node(const void* p_block, const uint32_t level, const Buddy* p_buddy) {
+	size_t index = ((char*)p_block - (char*)p_buddy->p_start) / (p_buddy->size >> level);
+	return ((size_t)1 << level) - 1 + index;
+}
+
+
+// free list helpers
+
+static void buddy_list_push(BuddyBlock* p_block, const uint32_t level, Buddy* p_buddy) {
+	p_block->p_prev = NULL;
+	p_block->p_next = p_buddy->p_free_lists[level];
+	if (p_block->p_next != NULL) {
+		p_block->p_next->p_prev = p_block;
+	}
+	p_buddy->p_free_lists[level] = p_block;
+
+	buddy_bit_set(p_buddy->p_free_bits, buddy_node(p_block, level, p_buddy));
+}
+
+static void buddy_list_remove(BuddyBlock* p_block, const uint32_t level, Buddy* p_buddy) {
+	if (p_block->p_prev != NULL) {
+		p_block->p_prev->p_next = p_block->p_next;
+	}
+	else {
+		p_buddy->p_free_lists[level] = p_block->p_next;
+	}
+	if (p_block->p_next != NULL) {
+		p_block->p_next->p_prev = p_block->p_prev;
+	}
+
+	buddy_bit_clear(p_buddy->p_free_bits, buddy_node(p_block, level, p_buddy));
+}
+
+
+// chunk source callbacks, so pools and frames can allocate from the region
+
+static void* buddy_source_alloc(const size_t size, void* p_context) {
+	return buddy_alloc(size, p_context);
+}
+
+static void buddy_source_free(void* p_memory, void* p_context) {
+	buddy_free(p_memory, p_context);
+}
+
+
+// mallocs a region of _size_ bytes (rounded up to a power of 2) plus the bitmaps for it
+// returns BUDDY_INVALID_INPUT if the region would need more than BUDDY_MAX_LEVELS levels
+//
+// Buddy buddy;
+// buddy_region_create(1 << 20, &buddy);
+BUDDY_RESULT buddy_region_create(const size_t size, Buddy* p_buddy) {
+	if (size == 0 || p_buddy == NULL) {
+		return BUDDY_INVALID_INPUT;
+	}
+
+	size_t region_size = BUDDY_MIN_BLOCK_SIZE;
+	uint32_t levels = 1;
+	while (region_size < size) {
+		region_size <<= 1;
+		levels++;
+	}
+	if (levels > BUDDY_MAX_LEVELS) {
+		return BUDDY_INVALID_INPUT;
+	}
+
+	size_t node_count = ((size_t)1 << levels) - 1;
+	size_t bitmap_size = (node_count + 7) / 8;
+
+	// the bitmaps go after the region so blocks keep malloc's alignment
+	void* p_memory = malloc(region_size + 2 * bitmap_size);
+	if (p_memory == NULL) {
+		return BUDDY_FAILURE;
+	}
+
+	p_buddy->p_start = p_memory;
+	p_buddy->size = region_size;
+	p_buddy->levels = levels;
+	memset(p_buddy->p_free_lists, 0, sizeof(p_buddy->p_free_lists));
+	p_buddy->p_split_bits = (uint8_t*)p_memory + region_size;
+	p_buddy->p_free_bits = p_buddy->p_split_bits + bitmap_size;
+	memset(p_buddy->p_split_bits, 0, 2 * bitmap_size);
+
+	p_buddy->source.p_alloc = buddy_source_alloc;
+	p_buddy->source.p_free = buddy_source_free;
+	p_buddy->source.p_context = p_buddy;
+
+	// the whole region starts out as one free block
+	buddy_list_push(p_memory, 0, p_buddy);
+
+	return BUDDY_SUCCESS;
+}
+
+
+// allocates a block of at least _alloc_size_ bytes
+// takes the smallest free block that fits, and splits bigger blocks down to size if there isn't one
+// returns NULL if there is no free block big enough
+void* buddy_alloc(const size_t alloc_size, Buddy* p_buddy) {
+	if (p_buddy == NULL || p_buddy->p_start == NULL || alloc_size == 0 || alloc_size > p_buddy->size) {
+		return NULL;
+	}
+
+	// find the level with the smallest blocks that still fit alloc_size
+	uint32_t target_level = p_buddy->levels - 1;
+	size_t block_size = BUDDY_MIN_BLOCK_SIZE;
+	while (block_size < alloc_size) {
+		block_size <<= 1;
+		target_level--;
+	}
+
+	// find the nearest level at or above that with a free block
+	uint32_t level = target_level;
+	while (p_buddy->p_free_lists[level] == NULL) {
+		if (level == 0) { return NULL; }
+		level--;
+	}
+
+	BuddyBlock* p_block = p_buddy->p_free_lists[level];
+	buddy_list_remove(p_block, level, p_buddy);
+
+	// split it in half until it's the right size. the left half keeps going, the right half is freed
+	while (level < target_level) {
+		buddy_bit_set(p_buddy->p_split_bits, buddy_node(p_block, level, p_buddy));
+		level++;
+		buddy_list_push((BuddyBlock*)((char*)p_block + (p_buddy->size >> level)), level, p_buddy);
+	}
+
+	return p_block;
+}
+
+
+// walks down from the root to the allocated block that starts at _p_location_
+// returns its level, and its node through _p_node_
+static uint32_t buddy_find_block(const void* p_location, size_t* p_node, const Buddy* p_buddy) {
+	size_t node = 0;
+	uint32_t level = 0;
+	char* p_block = p_buddy->p_start;
+
+	while (buddy_bit_get(p_buddy->p_split_bits, node)) {
+		level++;
+		size_t half = p_buddy->size >> level;
+		if ((char*)p_location >= p_block + half) {
+			p_block += half;
+			node = 2 * node + 2;
+		}
+		else {
+			node = 2 * node + 1;
+		}
+	}
+
+	assert(p_block == p_location);								// not the start of a block
+	assert(!buddy_bit_get(p_buddy->p_free_bits, node));			// double free
+
+	*p_node = node;
+	return level;
+}
+
+// frees the block at _p_location_, then merges it with its buddy for as long as the buddy is free
+void buddy_free(void* p_location, Buddy* p_buddy) {
+	if (p_buddy == NULL || p_location == NULL) { return; }
+	assert((char*)p_location >= (char*)p_buddy->p_start && (char*)p_location < (char*)p_buddy->p_start + p_buddy->size);
+
+	size_t node;
+	uint32_t level = buddy_find_block(p_location, &node, p_buddy);
+	char* p_block = p_location;
+
+	while (level > 0) {
+		// left children have odd indices, their buddy is the next node. right children are the opposite
+		size_t buddy_node = (node & 1) ? node + 1 : node - 1;
+		if (!buddy_bit_get(p_buddy->p_free_bits, buddy_node)) { break; }
+
+		size_t block_size = p_buddy->size >> level;
+		char* p_buddy_block = (node & 1) ? p_block + block_size : p_block - block_size;
+		buddy_list_remove((BuddyBlock*)p_buddy_block, level, p_buddy);
+
+		if (p_buddy_block < p_block) {
+			p_block = p_buddy_block;
+		}
+		node = (node - 1) / 2;
+		level--;
+		buddy_bit_clear(p_buddy->p_split_bits, node);
+	}
+
+	buddy_list_push((BuddyBlock*)p_block, level, p_buddy);
+}
+
+
+// returns the size of the block that was allocated at _p_location_
+size_t buddy_block_size(const void* p_location, const Buddy* p_buddy) {
+	if (p_buddy == NULL || p_location == NULL) { return 0; }
+
+	size_t node;
+	return p_buddy->size >> buddy_find_block(p_location, &node, p_buddy);
+}
+
+// returns the total size of every free block
+size_t buddy_free_bytes(const Buddy* p_buddy) {
+	size_t total = 0;
+
+	for (uint32_t level = 0; level < p_buddy->levels; ++level) {
+		for (BuddyBlock* p_block = p_buddy->p_free_lists[level]; p_block != NULL; p_block = p_block->p_next) {
+			total += p_buddy->size >> level;
+		}
+	}
+
+	return total;
+}
+
+
+// frees the whole region. Every pool or frame using p_buddy->source has to be freed first
+void buddy_region_free(Buddy* p_buddy) {
+	if (p_buddy == NULL) { return; }
+
+	free(p_buddy->p_start);
+
+	p_buddy->p_start = NULL;
+	p_buddy->size = 0;
+	p_buddy->levels = 0;
+	memset(p_buddy->p_free_lists, 0, sizeof(p_buddy->p_free_lists));
+	p_buddy->p_split_bits = NULL;
+	p_buddy->p_free_bits = NULL;
+}
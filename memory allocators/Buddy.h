@@ -0,0 +1,71 @@
+#ifndef BUDDY_H
+#define BUDDY_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "Chunk.h"
+
+// This is a buddy allocator. It sits between Frame (one fixed size) and Pool (everything is freed 
+// at once): blocks can be any size and each one can be freed on its own.
+//
+// It mallocs one big region up front, with a size that is a power of 2. The region is treated as
+// a binary tree of blocks. Level 0 is the whole region, and each level down splits every block in 
+// half, until blocks are BUDDY_MIN_BLOCK_SIZE bytes. An allocation rounds its size up to a power
+// of 2, and takes a free block of that size, splitting a bigger block in half as many times as
+// needed. The two halves of a split block are "buddies". When a block is freed and its buddy is 
+// free too, they merge back into the parent block, and so on up the tree. Both are O(log n).
+//
+// The tree is tracked with two bitmaps, with one bit per node:
+// |	split_bits: the node has been split into its two children
+// |	free_bits:  the node is a free block sitting on its level's free list
+// a node with neither bit set is an allocated block. buddy_free uses split_bits to walk down from 
+// the root and find out how big the block it was handed is, so callers don't have to pass a size.
+//
+// Free blocks on each level make a doubly linked list (stored in the free blocks themselves), 
+// so a buddy can be pulled off its list in O(1) when it merges.
+//
+// p_buddy->source can be handed to pool_create_source/pool_heap_create_source/frame_create_source so
+// pools and frames take their chunks from the region, and give them back to it when freed.
+//
+// This isn't thread safe, the same way Pool and Frame aren't.
+
+#define BUDDY_MIN_BLOCK_SIZE 32
+#define BUDDY_MAX_LEVELS 32
+
+typedef int BUDDY_RESULT;
+enum {
+	BUDDY_FAILURE,
+	BUDDY_SUCCESS,
+	BUDDY_INVALID_INPUT
+};
+
+typedef struct BuddyBlock {
+	struct BuddyBlock* p_next;		// next free block on the same level. NULL at the end
+	struct BuddyBlock* p_prev;		// previous free block on the same level. NULL at the head
+}BuddyBlock;
+
+typedef struct {
+	void* p_start;								// pointer to the region
+	size_t size;								// size of the region in bytes, a power of 2
+	uint32_t levels;							// number of levels. blocks on the last level are BUDDY_MIN_BLOCK_SIZE
+	BuddyBlock* p_free_lists[BUDDY_MAX_LEVELS];	// free blocks on each level
+	uint8_t* p_split_bits;						// one bit per node, set if the node is split
+	uint8_t* p_free_bits;						// one bit per node, set if the node is on a free list
+	ChunkSource source;							// chunk source that allocates from this region
+}Buddy;
+
+BUDDY_RESULT buddy_region_create(const size_t size, Buddy* p_buddy);
+
+void* buddy_alloc(const size_t alloc_size, Buddy* p_buddy);
+void buddy_free(void* p_location, Buddy* p_buddy);
+
+size_t buddy_block_size(const void* p_location, const Buddy* p_buddy);
+size_t buddy_free_bytes(const Buddy* p_buddy);
+
+void buddy_region_free(Buddy* p_buddy);
+
+#endif
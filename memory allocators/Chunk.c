@@ -0,0 +1,20 @@
+#include "Chunk.h"
+
+// allocates _size_ bytes from _p_source_, or from malloc if _p_source_ is NULL
+void* chunk_alloc(const size_t size, const ChunkSource* p_source) {
+	if (p_source == NULL) {
+		return malloc(size);
+	}
+	return p_source->p_alloc(size, p_source->p_context);
+}
+
+// gives _p_memory_ back to the source it came from
+void chunk_free(void* p_memory, const ChunkSource* p_source) {
+	if (p_memory == NULL) { return; }
+
+	if (p_source == NULL) {
+		free(p_memory);
+		return;
+	}
+	p_source->p_free(p_memory, p_source->p_context);
+}
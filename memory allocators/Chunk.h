@@ -0,0 +1,22 @@
+#ifndef CHUNK_H
+#define CHUNK_H
+
+#include <stdlib.h>
+
+// A chunk source is where an allocator gets the big chunks of memory it carves up. By default 
+// (a NULL source) that is just malloc and free, but pools and frames can be pointed at something
+// else, like a Buddy region, so chunks given back by one allocator get reused by the next one 
+// without going to the system.
+//
+// the source has to outlive every pool/frame that uses it.
+
+typedef struct {
+	void* (*p_alloc)(const size_t size, void* p_context);	// returns NULL on failure
+	void (*p_free)(void* p_memory, void* p_context);
+	void* p_context;										// passed to p_alloc and p_free
+}ChunkSource;
+
+void* chunk_alloc(const size_t size, const ChunkSource* p_source);
+void chunk_free(void* p_memory, const ChunkSource* p_source);
+
+#endif
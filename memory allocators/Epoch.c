@@ -0,0 +1,165 @@
+#include "Epoch.h"
+
+// frees every slab in _p_bucket_ back to the frame with one lock
+static void epoch_bucket_free(EpochBucket* p_bucket, EpochThread* p_thread, Epoch* p_epoch) {
+	if (p_bucket->count == 0) { return; }
+
+	slab_s_free_batch(p_bucket->slabs, p_bucket->count, p_epoch->p_frame);
+	p_thread->retired -= p_bucket->count;
+	p_bucket->count = 0;
+}
+
+// frees the buckets of _p_thread_ that no reader can see anymore, given the global epoch _epoch_
+static void epoch_free_safe(const uint64_t epoch, EpochThread* p_thread, Epoch* p_epoch) {
+	for (int i = 0; i < EPOCH_BUCKETS; ++i) {
+		EpochBucket* p_bucket = &p_thread->buckets[i];
+		if (p_bucket->count != 0 && p_bucket->epoch + 2 <= epoch) {
+			epoch_bucket_free(p_bucket, p_thread, p_epoch);
+		}
+	}
+}
+
+// moves the global epoch from _epoch_ to _epoch_ + 1 if every thread in a critical section has seen _epoch_
+// returns the global epoch afterwards
+static uint64_t epoch_try_advance(uint64_t epoch, Epoch* p_epoch) {
+	for (int i = 0; i < EPOCH_MAX_THREADS; ++i) {
+		uint64_t state = atomic_load(&p_epoch->threads[i].state);
+		if ((state & 1) && (state >> 1) != epoch) {
+			return epoch;	// someone is still reading in an older epoch
+		}
+	}
+
+	// if this fails, another thread advanced it already, which is just as good
+	atomic_compare_exchange_strong(&p_epoch->global_epoch, &epoch, epoch + 1);
+	return atomic_load(&p_epoch->global_epoch);
+}
+
+
+// sets up _p_epoch_ to reclaim slabs for _p_frame_
+EPOCH_RESULT epoch_create(Frame_s* p_frame, Epoch* p_epoch) {
+	if (p_frame == NULL || p_epoch == NULL) {
+		return EPOCH_INVALID_INPUT;
+	}
+	// retired slabs get freed from copies of their Slab_s, so a frame tracking handles for compaction
+	// would end up pointing at the wrong ones
+	if (p_frame->owners != NULL) {
+		return EPOCH_INVALID_INPUT;
+	}
+
+	memset(p_epoch, 0, sizeof(Epoch));
+	p_epoch->p_frame = p_frame;
+	atomic_init(&p_epoch->global_epoch, 0);
+	for (int i = 0; i < EPOCH_MAX_THREADS; ++i) {
+		atomic_init(&p_epoch->threads[i].state, 0);
+		atomic_init(&p_epoch->threads[i].in_use, 0);
+	}
+
+	return EPOCH_SUCCESS;
+}
+
+// claims a slot for the calling thread
+// a slot left behind by an unregistered thread may still hold retired slabs. the new owner 
+// just takes them over and frees them when they're safe
+// returns NULL if all EPOCH_MAX_THREADS slots are taken
+EpochThread* epoch_thread_register(Epoch* p_epoch) {
+	if (p_epoch == NULL) { return NULL; }
+
+	for (int i = 0; i < EPOCH_MAX_THREADS; ++i) {
+		int expected = 0;
+		if (atomic_compare_exchange_strong(&p_epoch->threads[i].in_use, &expected, 1)) {
+			return &p_epoch->threads[i];
+		}
+	}
+
+	return NULL;
+}
+
+// gives the slot back. has to be called outside of a critical section
+void epoch_thread_unregister(EpochThread* p_thread, Epoch* p_epoch) {
+	if (p_thread == NULL || p_epoch == NULL) { return; }
+	assert((atomic_load(&p_thread->state) & 1) == 0);	// still inside a critical section
+
+	epoch_reclaim(p_thread, p_epoch);
+	atomic_store(&p_thread->in_use, 0);
+}
+
+
+// starts a read side critical section. slabs reachable from here won't be freed until epoch_exit
+void epoch_enter(EpochThread* p_thread, Epoch* p_epoch) {
+	uint64_t epoch = atomic_load_explicit(&p_epoch->global_epoch, memory_order_relaxed);
+
+	// seq_cst, so the store is visible before any of the loads from the structure that follow it
+	atomic_store(&p_thread->state, (epoch << 1) | 1);
+}
+
+void epoch_exit(EpochThread* p_thread) {
+	atomic_store_explicit(&p_thread->state, 0, memory_order_release);
+}
+
+
+// hands _slab_ (already unlinked from the structure) over to be freed once no reader can see it
+// _slab_ is cleared, like slab_s_free does
+// every EPOCH_RETIRE_BATCH slabs, tries to advance the epoch and frees what's safe
+EPOCH_RESULT epoch_retire(Slab_s* slab, EpochThread* p_thread, Epoch* p_epoch) {
+	if (slab == NULL || slab->memory == NULL || p_thread == NULL || p_epoch == NULL) {
+		return EPOCH_INVALID_INPUT;
+	}
+
+	uint64_t epoch = atomic_load(&p_epoch->global_epoch);
+	EpochBucket* p_bucket = &p_thread->buckets[epoch % EPOCH_BUCKETS];
+
+	// a bucket still holding slabs from 3 or more epochs ago is safe to free before reusing it
+	if (p_bucket->epoch != epoch) {
+		epoch_bucket_free(p_bucket, p_thread, p_epoch);
+		p_bucket->epoch = epoch;
+	}
+
+	if (p_bucket->count == p_bucket->capacity) {
+		size_t new_capacity = p_bucket->capacity == 0 ? EPOCH_RETIRE_BATCH : p_bucket->capacity * 2;
+		Slab_s* p_slabs = realloc(p_bucket->slabs, new_capacity * sizeof(Slab_s));
+		if (p_slabs == NULL) { return EPOCH_FAILURE; }
+
+		p_bucket->slabs = p_slabs;
+		p_bucket->capacity = new_capacity;
+	}
+
+	p_bucket->slabs[p_bucket->count++] = *slab;
+	p_thread->retired++;
+	slab->memory = NULL;
+	slab->memory_size = 0;
+
+	if (p_thread->retired >= EPOCH_RETIRE_BATCH) {
+		epoch_reclaim(p_thread, p_epoch);
+	}
+
+	return EPOCH_SUCCESS;
+}
+
+// tries to advance the global epoch, then frees every slab _p_thread_ retired that is now safe
+void epoch_reclaim(EpochThread* p_thread, Epoch* p_epoch) {
+	if (p_thread == NULL || p_epoch == NULL) { return; }
+
+	uint64_t epoch = epoch_try_advance(atomic_load(&p_epoch->global_epoch), p_epoch);
+	epoch_free_safe(epoch, p_thread, p_epoch);
+}
+
+
+// frees every retired slab, safe or not, and the bucket arrays
+// no thread can be inside a critical section. the frame itself is left alone
+void epoch_free(Epoch* p_epoch) {
+	if (p_epoch == NULL) { return; }
+
+	for (int i = 0; i < EPOCH_MAX_THREADS; ++i) {
+		EpochThread* p_thread = &p_epoch->threads[i];
+		assert((atomic_load(&p_thread->state) & 1) == 0);
+
+		for (int j = 0; j < EPOCH_BUCKETS; ++j) {
+			epoch_bucket_free(&p_thread->buckets[j], p_thread, p_epoch);
+			free(p_thread->buckets[j].slabs);
+			p_thread->buckets[j].slabs = NULL;
+			p_thread->buckets[j].capacity = 0;
+		}
+	}
+
+	p_epoch->p_frame = NULL;
+}
@@ -0,0 +1,92 @@
+#ifndef EPOCH_H
+#define EPOCH_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdatomic.h>
+
+#include "Slab_s.h"
+
+// This is epoch based reclamation for slabs from a Frame_s. It's for lock free structures (queues,
+// hash tables...) built out of slabs. In those, a thread can unlink a slab while another thread is
+// still reading it, so the slab can't go back to the frame right away: slab_s_free would zero it
+// and put it back on frame->available while it's being read (use after free), and it could get 
+// handed out again and relinked under the reader (ABA).
+//
+// Instead, readers wrap every access to the structure in epoch_enter/epoch_exit, and writers hand 
+// unlinked slabs to epoch_retire instead of slab_s_free. 
+//
+// There is a global epoch counter. epoch_enter just copies the global epoch into the thread's slot,
+// and epoch_exit marks the slot as quiescent, so readers only pay for one atomic store each way 
+// and never touch shared cache lines. Retired slabs are kept in a per thread list for the epoch 
+// they were retired in. The global epoch can only move from e to e + 1 once every thread that is 
+// inside a critical section has seen e. So once the global epoch is 2 past the epoch a slab was 
+// retired in, every reader that could have seen it has left, and it is freed. Retired slabs pile 
+// up until there are EPOCH_RETIRE_BATCH of them, then the thread tries to advance the epoch and 
+// frees whatever is safe with one slab_s_free_batch.
+//
+// Each thread that uses the Epoch registers first to get its own slot:
+//
+// EpochThread* p_thread = epoch_thread_register(&epoch);
+// 
+// epoch_enter(p_thread, &epoch);
+// Node* p_node = atomic_load(&p_head);
+// ... read p_node ...
+// epoch_exit(p_thread);
+//
+// epoch_enter(p_thread, &epoch);
+// ... unlink a node ...
+// epoch_retire(&node_slab, p_thread, &epoch);
+// epoch_exit(p_thread);
+//
+// epoch_thread_unregister(p_thread, &epoch);
+
+#define EPOCH_MAX_THREADS 64
+#define EPOCH_RETIRE_BATCH 64
+#define EPOCH_BUCKETS 3					// slabs retired in epoch e go in bucket e % 3
+
+typedef int EPOCH_RESULT;
+enum {
+	EPOCH_FAILURE,
+	EPOCH_SUCCESS,
+	EPOCH_INVALID_INPUT
+};
+
+typedef struct {
+	Slab_s* slabs;						// retired slabs, malloc'd and grown as needed
+	size_t count;						// number of slabs in the bucket
+	size_t capacity;					// number of slabs that fit before it has to grow
+	uint64_t epoch;						// epoch the slabs in the bucket were retired in
+}EpochBucket;
+
+// each slot gets its own cache line, so readers entering and exiting don't false share
+typedef struct {
+	_Alignas(SLAB_CACHE_LINE_SIZE) atomic_uint_fast64_t state;	// (epoch << 1) | 1 inside a critical section, 0 outside
+	atomic_int in_use;					// 1 while a thread has the slot registered
+	EpochBucket buckets[EPOCH_BUCKETS];	// slabs this thread retired, by epoch. only touched by its thread
+	size_t retired;						// total slabs across the buckets
+}EpochThread;
+
+typedef struct {
+	Frame_s* p_frame;					// frame retired slabs are freed back to
+	_Alignas(SLAB_CACHE_LINE_SIZE) atomic_uint_fast64_t global_epoch;
+	EpochThread threads[EPOCH_MAX_THREADS];
+}Epoch;
+
+EPOCH_RESULT epoch_create(Frame_s* p_frame, Epoch* p_epoch);
+
+EpochThread* epoch_thread_register(Epoch* p_epoch);
+void epoch_thread_unregister(EpochThread* p_thread, Epoch* p_epoch);
+
+void epoch_enter(EpochThread* p_thread, Epoch* p_epoch);
+void epoch_exit(EpochThread* p_thread);
+
+EPOCH_RESULT epoch_retire(Slab_s* slab, EpochThread* p_thread, Epoch* p_epoch);
+void epoch_reclaim(EpochThread* p_thread, Epoch* p_epoch);
+
+void epoch_free(Epoch* p_epoch);
+
+#endif
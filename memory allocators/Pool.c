@@ -56,11 +56,18 @@ void pool_print(const Pool* pool) {
 //
 // Pool new_pool = pool_create(sizeof(float) * 100);
 Pool pool_create(const size_t size) {
+	return pool_create_source(size, NULL);
+}
+
+// same as pool_create, but the chunk (and any chunks the pool grows into) comes from _p_source_
+//
+// Pool new_pool = pool_create_source(4096, &buddy.source);
+Pool pool_create_source(const size_t size, const ChunkSource* p_source) {
 	if (size <= 0) {
 		return POOL_ERROR;
 	}
 
-	void* p_memory = malloc(size);
+	void* p_memory = chunk_alloc(size, p_source);
 
 	if (p_memory == NULL) {
 		return POOL_ERROR;
@@ -70,18 +77,25 @@ Pool pool_create(const size_t size) {
 		p_memory,	// p_start
 		p_memory,	// p_current
 		size,		// size
-		NULL		// p_next
+		NULL,		// p_next
+		p_source,	// p_source
+		0			// flags
 	};
 }
 
 // allocates space for a pool, but also for the member variables of a Pool struct
 // returns a pointer to the new pool if successful, but NULL if not
 Pool* pool_heap_create(const size_t size) {
+	return pool_heap_create_source(size, NULL);
+}
+
+// same as pool_heap_create, but the memory comes from _p_source_
+Pool* pool_heap_create_source(const size_t size, const ChunkSource* p_source) {
 	if (size <= 0) {
 		return NULL;
 	}
 	
-	void* p_memory = malloc(sizeof(Pool) + size);
+	void* p_memory = chunk_alloc(sizeof(Pool) + size, p_source);
 	if(p_memory == NULL){ return NULL; }
 
 	// offset the pool memory to leave room for the struct
@@ -91,7 +105,9 @@ Pool* pool_heap_create(const size_t size) {
 		p_pool_memory_start,	// p_start
 		p_pool_memory_start,	// p_current
 		size,					// size
-		NULL					// p_next
+		NULL,					// p_next
+		p_source,				// p_source
+		0						// flags
 	};	
 
 	memcpy(p_memory, &new_pool, sizeof(Pool));	// the size member is const, so we can't just assign the struct normally
@@ -99,6 +115,52 @@ Pool* pool_heap_create(const size_t size) {
 	return p_memory;
 }
 
+// returns a pool over _size_ bytes of caller owned memory at _p_buffer_ (a stack array, a static 
+// buffer, memory from another pool...). No heap allocation happens here.
+// with POOL_SPILL_ALLOWED, allocations that don't fit chain on malloc'd chunks like a normal pool.
+// with POOL_SPILL_NEVER, they just return NULL.
+// pool_free frees any spilled chunks but never touches _p_buffer_
+// returns POOL_ERROR on failure
+//
+// char buffer[1024];
+// Pool pool = pool_create_from_buffer(buffer, sizeof(buffer), POOL_SPILL_NEVER);
+Pool pool_create_from_buffer(void* p_buffer, const size_t size, const POOL_SPILL spill) {
+	if (p_buffer == NULL || size <= 0) {
+		return POOL_ERROR;
+	}
+
+	return (Pool) {
+		p_buffer,	// p_start
+		p_buffer,	// p_current
+		size,		// size
+		NULL,		// p_next
+		NULL,		// p_source
+		POOL_FLAG_BORROWED | (spill == POOL_SPILL_NEVER ? POOL_FLAG_NO_SPILL : 0)	// flags
+	};
+}
+
+// same as pool_create_from_buffer, but the Pool struct goes at the start of _p_buffer_ too,
+// like pool_heap_create. _p_buffer_ is rounded up to max_align_t for the struct first, since it
+// could come from anywhere (even another pool), and the pool gets whatever is left after the struct
+// returns NULL if _p_buffer_ is too small
+Pool* pool_heap_create_from_buffer(void* p_buffer, const size_t size, const POOL_SPILL spill) {
+	if (p_buffer == NULL) {
+		return NULL;
+	}
+
+	size_t misalignment = (uintptr_t)p_buffer & (_Alignof(max_align_t) - 1);
+	size_t padding = misalignment == 0 ? 0 : _Alignof(max_align_t) - misalignment;
+	if (size <= padding + sizeof(Pool)) {
+		return NULL;
+	}
+
+	Pool* p_pool = (Pool*)((char*)p_buffer + padding);
+	Pool new_pool = pool_create_from_buffer(p_pool + 1, size - padding - sizeof(Pool), spill);
+	memcpy(p_pool, &new_pool, sizeof(Pool));	// the size member is const, so we can't just assign the struct normally
+
+	return p_pool;
+}
+
 
 // things that allocate new pools if an old one runs out of capacity
 
@@ -110,10 +172,12 @@ Pool* pool_heap_create(const size_t size) {
 Pool* pool_realloc(const size_t alloc_size, Pool* p_pool) {
 	assert(p_pool->p_next == NULL);
 
+	if (p_pool->flags & POOL_FLAG_NO_SPILL) { return NULL; }
+
 	size_t new_size = pool_new_size(alloc_size, p_pool);
 	if(new_size == 0){ return NULL; }
 
-	p_pool->p_next = pool_heap_create(new_size); // pool_heap_create returns NULL upon failure
+	p_pool->p_next = pool_heap_create_source(new_size, p_pool->p_source); // returns NULL upon failure
 	return p_pool->p_next;
 }
 
@@ -191,11 +255,14 @@ void pool_heap_free(Pool* p_pool) {
 	while (p_pool != NULL) {
 		Pool* p_old_pool = p_pool;
 		p_pool = p_pool->p_next;
-		free(p_old_pool);
+		if (!(p_old_pool->flags & POOL_FLAG_BORROWED)) {
+			chunk_free(p_old_pool, p_old_pool->p_source);
+		}
 	}
 }
 
 // frees _pool_ and all pools it has attached to it with p_next
+// a borrowed first chunk (pool_create_from_buffer) is left alone
 void pool_free(Pool* p_pool) {
 	if (p_pool->p_start == NULL) {
 		return;
@@ -205,13 +272,17 @@ void pool_free(Pool* p_pool) {
 		pool_heap_free(p_pool->p_next);
 	}
 
-	free(p_pool->p_start);
+	if (!(p_pool->flags & POOL_FLAG_BORROWED)) {
+		chunk_free((void*)p_pool->p_start, p_pool->p_source);
+	}
 
 	Pool cleared_pool = {
 		NULL,
 		NULL,
 		0,
-		NULL
+		NULL,
+		NULL,
+		0
 	};
 
 	memcpy(p_pool, &cleared_pool, sizeof(Pool));
@@ -35,10 +35,14 @@
 #include <stdio.h>
 #include <string.h>
 #include <assert.h>
+#include <stdint.h>
+#include <stddef.h>
+
+#include "Chunk.h"
 
 #define POOL_SIZE_CAP 16000
 #define POOL_GROWTH_FACTOR 1.5f
-#define POOL_ERROR (Pool){NULL, NULL, 0, NULL}
+#define POOL_ERROR (Pool){NULL, NULL, 0, NULL, NULL, 0}
 
 // these are for the case where I want a sentinel return value for functions like pool_create or pool_alloc
 typedef int POOL_RESULT;
@@ -48,11 +52,24 @@ typedef int POOL_BOOL;
 #define POOL_TRUE 1
 #define POOL_FALSE 0
 
+// flags for pools made over memory the caller owns (pool_create_from_buffer)
+typedef unsigned int POOL_FLAGS;
+#define POOL_FLAG_BORROWED 1	// the pool doesn't own this chunk, so it is never freed
+#define POOL_FLAG_NO_SPILL 2	// don't chain on new chunks when the pool is full, just fail the allocation
+
+// whether a pool over caller memory may chain on malloc'd chunks once the buffer is full
+typedef enum {
+	POOL_SPILL_NEVER,
+	POOL_SPILL_ALLOWED
+}POOL_SPILL;
+
 typedef struct {
 	const void* p_start;	// pointer to the start of the pool
 	void* p_current;		// pointer to the next free address
 	const size_t size;		// size of the pool in bytes
 	struct Pool* p_next;	// pointer to the next pool. NULL if there is none
+	const ChunkSource* p_source;	// where this pool's chunks come from. NULL for malloc/free
+	POOL_FLAGS flags;		// POOL_FLAG_*. 0 for normal pools
 }Pool;
 
 // utilities
@@ -64,7 +81,11 @@ void pool_print(const Pool* p_pool);
 
 // stuff that creates pools
 Pool pool_create(const size_t size);
+Pool pool_create_source(const size_t size, const ChunkSource* p_source);
 Pool* pool_heap_create(const size_t size);
+Pool* pool_heap_create_source(const size_t size, const ChunkSource* p_source);
+Pool pool_create_from_buffer(void* p_buffer, const size_t size, const POOL_SPILL spill);
+Pool* pool_heap_create_from_buffer(void* p_buffer, const size_t size, const POOL_SPILL spill);
 
 // stuff that creates new pools if a pool runs out of capacity
 Pool* pool_realloc(const size_t alloc_size, Pool* p_pool);
@@ -0,0 +1,336 @@
+#ifndef _WIN32
+#define _POSIX_C_SOURCE 200809L		// ftruncate, which strict C modes hide
+#endif
+
+#include "Pool_p.h"
+
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#endif
+
+//	typedef struct {
+//		uint32_t magic;						// POOL_P_MAGIC
+//		uint32_t version;					// POOL_P_VERSION
+//		uint64_t header_size;				// sizeof(PoolHeader_p) when the file was made
+//		uint64_t size;						// size of the file in bytes
+//		uint64_t current;					// offset of the next free byte (p_current)
+//		uint64_t root;						// offset of the root object. 0 if there isn't one
+//		uint32_t clean;						// 1 if the file was closed with pool_p_close
+//		uint32_t padding;
+//	}PoolHeader_p;
+
+
+// platform stuff. Everything that touches the OS goes through these few functions
+
+// opens (or creates) the file at _path_ and stores its size in _p_file_size_
+static POOL_P_RESULT pool_p_file_open(const char* path, uint64_t* p_file_size, Pool_p* p_pool) {
+#ifdef _WIN32
+	HANDLE file = CreateFileA(path, GENERIC_READ | GENERIC_WRITE, 0, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+	if (file == INVALID_HANDLE_VALUE) { return POOL_P_FAILURE; }
+
+	LARGE_INTEGER file_size;
+	if (!GetFileSizeEx(file, &file_size)) {
+		CloseHandle(file);
+		return POOL_P_FAILURE;
+	}
+
+	p_pool->p_file = file;
+	p_pool->p_mapping = NULL;
+	*p_file_size = (uint64_t)file_size.QuadPart;
+#else
+	int file = open(path, O_RDWR | O_CREAT, 0644);
+	if (file < 0) { return POOL_P_FAILURE; }
+
+	struct stat file_stat;
+	if (fstat(file, &file_stat) != 0) {
+		close(file);
+		return POOL_P_FAILURE;
+	}
+
+	p_pool->file = file;
+	*p_file_size = (uint64_t)file_stat.st_size;
+#endif
+	return POOL_P_SUCCESS;
+}
+
+static void pool_p_file_close(Pool_p* p_pool) {
+#ifdef _WIN32
+	CloseHandle(p_pool->p_file);
+	p_pool->p_file = NULL;
+#else
+	close(p_pool->file);
+	p_pool->file = -1;
+#endif
+}
+
+// maps the first _size_ bytes of the file, growing the file first if it is smaller than that
+static POOL_P_RESULT pool_p_map(const uint64_t size, Pool_p* p_pool) {
+#ifdef _WIN32
+	// creating the mapping with a bigger size than the file grows the file
+	HANDLE mapping = CreateFileMappingA(p_pool->p_file, NULL, PAGE_READWRITE, (DWORD)(size >> 32), (DWORD)size, NULL);
+	if (mapping == NULL) { return POOL_P_FAILURE; }
+
+	void* p_memory = MapViewOfFile(mapping, FILE_MAP_ALL_ACCESS, 0, 0, (SIZE_T)size);
+	if (p_memory == NULL) {
+		CloseHandle(mapping);
+		return POOL_P_FAILURE;
+	}
+
+	p_pool->p_mapping = mapping;
+#else
+	struct stat file_stat;
+	if (fstat(p_pool->file, &file_stat) != 0) { return POOL_P_FAILURE; }
+	if ((uint64_t)file_stat.st_size < size && ftruncate(p_pool->file, (off_t)size) != 0) {
+		return POOL_P_FAILURE;
+	}
+
+	void* p_memory = mmap(NULL, (size_t)size, PROT_READ | PROT_WRITE, MAP_SHARED, p_pool->file, 0);
+	if (p_memory == MAP_FAILED) { return POOL_P_FAILURE; }
+#endif
+	p_pool->p_header = p_memory;
+	return POOL_P_SUCCESS;
+}
+
+static void pool_p_unmap(Pool_p* p_pool) {
+	if (p_pool->p_header == NULL) { return; }
+#ifdef _WIN32
+	UnmapViewOfFile(p_pool->p_header);
+	CloseHandle(p_pool->p_mapping);
+	p_pool->p_mapping = NULL;
+#else
+	munmap(p_pool->p_header, (size_t)p_pool->p_header->size);
+#endif
+	p_pool->p_header = NULL;
+}
+
+// writes the first _size_ bytes of the mapping back to the file and waits for it
+static POOL_P_RESULT pool_p_flush(const size_t size, Pool_p* p_pool) {
+#ifdef _WIN32
+	if (!FlushViewOfFile(p_pool->p_header, size) || !FlushFileBuffers(p_pool->p_file)) {
+		return POOL_P_FAILURE;
+	}
+#else
+	if (msync(p_pool->p_header, size, MS_SYNC) != 0) {
+		return POOL_P_FAILURE;
+	}
+#endif
+	return POOL_P_SUCCESS;
+}
+
+
+// helpers
+
+static uint64_t pool_p_align(const uint64_t size) {
+	return (size + POOL_P_ALIGNMENT - 1) & ~(uint64_t)(POOL_P_ALIGNMENT - 1);
+}
+
+// returns true (1) if the header at the start of the mapping belongs to a file this version made,
+// that was closed properly
+static int pool_p_header_valid(const PoolHeader_p* p_header, const uint64_t file_size) {
+	return p_header->magic == POOL_P_MAGIC
+		&& p_header->version == POOL_P_VERSION
+		&& p_header->header_size == sizeof(PoolHeader_p)
+		&& p_header->size == file_size
+		&& p_header->current >= pool_p_align(sizeof(PoolHeader_p))
+		&& p_header->current <= p_header->size
+		&& p_header->root < p_header->current
+		&& p_header->clean == 1;
+}
+
+// grows the file so _alloc_size_ more bytes fit, then maps it again
+// every pointer into the pool is invalid after this
+static POOL_P_RESULT pool_p_grow(const uint64_t alloc_size, Pool_p* p_pool) {
+	PoolHeader_p header = *p_pool->p_header;
+
+	uint64_t new_size = (uint64_t)(header.size * POOL_P_GROWTH_FACTOR);
+	if (new_size < header.current + alloc_size) {
+		new_size = header.current + alloc_size;
+	}
+
+	pool_p_unmap(p_pool);
+	if (pool_p_map(new_size, p_pool) != POOL_P_SUCCESS) {
+		// try to get the old mapping back so the pool is still usable
+		if (pool_p_map(header.size, p_pool) != POOL_P_SUCCESS) {
+			p_pool->p_header = NULL;
+			pool_p_file_close(p_pool);
+		}
+		return POOL_P_FAILURE;
+	}
+
+	p_pool->p_header->size = new_size;
+	return POOL_P_SUCCESS;
+}
+
+
+// pool creators:
+
+// maps the file at _path_ as a pool
+// if the file doesn't exist or is empty, it is created with room for _size_ bytes of allocations,
+// and POOL_P_CREATED is returned. if it holds a valid pool, that pool is mapped back in as it was
+// and POOL_P_SUCCESS is returned.
+// returns POOL_P_BAD_FILE if the file holds something else, a different version, or a pool that
+// wasn't closed cleanly. The file is left untouched in that case
+POOL_P_RESULT pool_p_open(const char* path, const size_t size, Pool_p* p_pool) {
+	if (path == NULL || p_pool == NULL) {
+		return POOL_P_INVALID_INPUT;
+	}
+	p_pool->p_header = NULL;
+
+	uint64_t file_size;
+	if (pool_p_file_open(path, &file_size, p_pool) != POOL_P_SUCCESS) {
+		return POOL_P_FAILURE;
+	}
+
+	if (file_size == 0) {
+		if (size == 0) {
+			pool_p_file_close(p_pool);
+			return POOL_P_INVALID_INPUT;
+		}
+
+		uint64_t data_start = pool_p_align(sizeof(PoolHeader_p));
+		if (pool_p_map(data_start + size, p_pool) != POOL_P_SUCCESS) {
+			pool_p_file_close(p_pool);
+			return POOL_P_FAILURE;
+		}
+
+		PoolHeader_p* p_header = p_pool->p_header;
+		p_header->magic = POOL_P_MAGIC;
+		p_header->version = POOL_P_VERSION;
+		p_header->header_size = sizeof(PoolHeader_p);
+		p_header->size = data_start + size;
+		p_header->current = data_start;
+		p_header->root = 0;
+		p_header->clean = 0;
+		p_header->padding = 0;
+
+		return POOL_P_CREATED;
+	}
+
+	if (file_size < sizeof(PoolHeader_p) || pool_p_map(file_size, p_pool) != POOL_P_SUCCESS) {
+		pool_p_file_close(p_pool);
+		return file_size < sizeof(PoolHeader_p) ? POOL_P_BAD_FILE : POOL_P_FAILURE;
+	}
+
+	if (!pool_p_header_valid(p_pool->p_header, file_size)) {
+		pool_p_unmap(p_pool);
+		pool_p_file_close(p_pool);
+		return POOL_P_BAD_FILE;
+	}
+
+	// mark the file as open, and make sure that hits the disk before anything else changes, so a
+	// crash while it's open is caught on the next start
+	p_pool->p_header->clean = 0;
+	pool_p_flush(sizeof(PoolHeader_p), p_pool);
+
+	return POOL_P_SUCCESS;
+}
+
+
+// things that allocate to the pool
+
+// allocates _alloc_size_ bytes (rounded up to POOL_P_ALIGNMENT) from the pool
+// grows the file if it's full, which invalidates every pointer into the pool
+// returns NULL on failure
+void* pool_p_raw_alloc(const size_t alloc_size, Pool_p* p_pool) {
+	if (p_pool == NULL || p_pool->p_header == NULL || alloc_size == 0) {
+		return NULL;
+	}
+
+	uint64_t size = pool_p_align(alloc_size);
+	if (p_pool->p_header->current + size > p_pool->p_header->size) {
+		if (pool_p_grow(size, p_pool) != POOL_P_SUCCESS) { return NULL; }
+	}
+
+	void* result = (char*)p_pool->p_header + p_pool->p_header->current;
+	p_pool->p_header->current += size;
+
+	return result;
+}
+
+void* pool_p_alloc(const void* data, const size_t alloc_size, Pool_p* p_pool) {
+	if (data == NULL) {
+		return NULL;
+	}
+
+	void* result = pool_p_raw_alloc(alloc_size, p_pool);
+	if (result == NULL) {
+		return NULL;
+	}
+
+	memcpy(result, data, alloc_size);
+	return result;
+}
+
+
+// pointer stuff
+
+// returns the offset of _p_location_ from the start of the file. NULL gives 0
+uint64_t pool_p_offset(const void* p_location, const Pool_p* p_pool) {
+	if (p_location == NULL) { return 0; }
+	assert((char*)p_location > (char*)p_pool->p_header && (char*)p_location < (char*)p_pool->p_header + p_pool->p_header->size);
+
+	return (uint64_t)((char*)p_location - (char*)p_pool->p_header);
+}
+
+// returns the address of _offset_ in the current mapping. 0 gives NULL
+void* pool_p_pointer(const uint64_t offset, const Pool_p* p_pool) {
+	if (offset == 0) { return NULL; }
+	assert(offset < p_pool->p_header->size);
+
+	return (char*)p_pool->p_header + offset;
+}
+
+// points the self relative pointer at _p_field_ to _p_target_. both should be in the same pool
+void pool_p_rel_set(POOL_P_REL* p_field, const void* p_target) {
+	if (p_target == NULL) {
+		*p_field = 0;
+		return;
+	}
+	*p_field = (POOL_P_REL)((const char*)p_target - (const char*)p_field);
+}
+
+// returns what the self relative pointer at _p_field_ points to
+void* pool_p_rel_get(const POOL_P_REL* p_field) {
+	if (*p_field == 0) { return NULL; }
+	return (char*)p_field + *p_field;
+}
+
+void pool_p_set_root(const void* p_root, Pool_p* p_pool) {
+	p_pool->p_header->root = pool_p_offset(p_root, p_pool);
+}
+
+// returns the root object the pool was saved with, or NULL if none was set
+void* pool_p_get_root(const Pool_p* p_pool) {
+	return pool_p_pointer(p_pool->p_header->root, p_pool);
+}
+
+
+// stuff that saves/closes the pool
+
+// writes everything allocated so far back to the file and waits for it
+POOL_P_RESULT pool_p_sync(Pool_p* p_pool) {
+	if (p_pool == NULL || p_pool->p_header == NULL) {
+		return POOL_P_INVALID_INPUT;
+	}
+	return pool_p_flush((size_t)p_pool->p_header->current, p_pool);
+}
+
+// syncs the pool, marks the file as closed cleanly, then unmaps and closes it
+// everything allocated stays in the file for the next pool_p_open
+void pool_p_close(Pool_p* p_pool) {
+	if (p_pool == NULL || p_pool->p_header == NULL) { return; }
+
+	// data first, then the clean flag, so a crash in between still leaves the file marked dirty
+	pool_p_sync(p_pool);
+	p_pool->p_header->clean = 1;
+	pool_p_flush(sizeof(PoolHeader_p), p_pool);
+
+	pool_p_unmap(p_pool);
+	pool_p_file_close(p_pool);
+}
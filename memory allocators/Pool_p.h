@@ -0,0 +1,96 @@
+#ifndef POOL_P_H
+#define POOL_P_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+// This is the persistent version of the pool allocator. Instead of malloc'd chunks, the pool is a
+// file mapped into memory, so whatever gets built in it is still there the next time the program
+// starts. Re-opening the file maps it straight back in (zero copy), instead of rebuilding 
+// everything object by object.
+//
+// The file starts with a header that replaces p_start/p_current/p_next: it stores offsets from the
+// start of the file instead of pointers, since the file can be mapped at a different address every
+// time it is opened. When the pool runs out of room, the file is grown by POOL_GROWTH_FACTOR and
+// mapped again, so one bump offset covers the whole file and there is no chain of chunks to track.
+//
+// Because of that, raw pointers into the pool are only good until the next allocation that grows
+// the file, or until the pool is closed. Anything stored IN the pool has to point at other things
+// in the pool with either:
+// |	offsets from the start of the file (pool_p_offset/pool_p_pointer), or
+// |	self relative pointers (POOL_P_REL), which store the distance from the pointer field itself
+// |	to the target. Those don't need the pool to be dereferenced.
+// The header also has a root offset, so the next run can find where the structure starts.
+//
+// The header has a magic number and a version, and a clean flag that is cleared while the file is 
+// open and set again by pool_p_close. A file that doesn't match, or that wasn't closed cleanly 
+// (it may be half written) is rejected with POOL_P_BAD_FILE, so the caller can rebuild it.
+//
+// Pool_p pool;
+// if (pool_p_open("cache.bin", 1 << 20, &pool) == POOL_P_CREATED) {
+//     Node* p_root = pool_p_raw_alloc(sizeof(Node), &pool);
+//     ... build ...
+//     pool_p_set_root(p_root, &pool);
+// }
+// Node* p_root = pool_p_get_root(&pool);
+// pool_p_close(&pool);
+
+#define POOL_P_MAGIC 0x506f6f6cu		// "Pool"
+#define POOL_P_VERSION 1
+#define POOL_P_ALIGNMENT 8				// every allocation is aligned to this
+#define POOL_P_GROWTH_FACTOR 1.5f
+
+typedef int POOL_P_RESULT;
+enum {
+	POOL_P_FAILURE,
+	POOL_P_SUCCESS,						// an existing file was mapped back in
+	POOL_P_CREATED,						// the file was new (or empty), so the pool is empty
+	POOL_P_INVALID_INPUT,
+	POOL_P_BAD_FILE						// wrong magic/version/layout, or it wasn't closed cleanly
+};
+
+// self relative pointer. stores (target address - address of this field), 0 means NULL
+typedef int64_t POOL_P_REL;
+
+typedef struct {
+	uint32_t magic;						// POOL_P_MAGIC
+	uint32_t version;					// POOL_P_VERSION
+	uint64_t header_size;				// sizeof(PoolHeader_p) when the file was made, catches layout changes
+	uint64_t size;						// size of the file in bytes
+	uint64_t current;					// offset of the next free byte (p_current)
+	uint64_t root;						// offset of the root object. 0 if there isn't one
+	uint32_t clean;						// 1 if the file was closed with pool_p_close
+	uint32_t padding;
+}PoolHeader_p;
+
+typedef struct {
+	PoolHeader_p* p_header;				// start of the mapping. NULL if the pool isn't open
+#ifdef _WIN32
+	void* p_file;						// HANDLE of the file
+	void* p_mapping;					// HANDLE of the file mapping
+#else
+	int file;							// file descriptor
+#endif
+}Pool_p;
+
+POOL_P_RESULT pool_p_open(const char* path, const size_t size, Pool_p* p_pool);
+
+void* pool_p_raw_alloc(const size_t alloc_size, Pool_p* p_pool);
+void* pool_p_alloc(const void* data, const size_t alloc_size, Pool_p* p_pool);
+
+uint64_t pool_p_offset(const void* p_location, const Pool_p* p_pool);
+void* pool_p_pointer(const uint64_t offset, const Pool_p* p_pool);
+
+void pool_p_rel_set(POOL_P_REL* p_field, const void* p_target);
+void* pool_p_rel_get(const POOL_P_REL* p_field);
+
+void pool_p_set_root(const void* p_root, Pool_p* p_pool);
+void* pool_p_get_root(const Pool_p* p_pool);
+
+POOL_P_RESULT pool_p_sync(Pool_p* p_pool);
+void pool_p_close(Pool_p* p_pool);
+
+#endif
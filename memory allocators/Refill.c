@@ -0,0 +1,179 @@
+#include "Refill.h"
+
+// touches every page of _p_chunk_ so the page faults happen here instead of on the allocating thread
+static void refill_prefault(void* p_chunk, const size_t size) {
+	volatile char* p_bytes = p_chunk;
+	for (size_t i = 0; i < size; i += REFILL_PAGE_SIZE) {
+		p_bytes[i] = 0;
+	}
+	if (size > 0) {
+		p_bytes[size - 1] = 0;
+	}
+}
+
+// upstream calls, serialized since the upstream source might not be thread safe
+// malloc/free (NULL upstream) already are, so those skip the lock and never wait on the thread
+static void* refill_upstream_alloc(const size_t size, Refill* p_refill) {
+	if (p_refill->p_upstream == NULL) {
+		return chunk_alloc(size, NULL);
+	}
+
+	mtx_lock(&p_refill->upstream_lock);
+	void* p_chunk = chunk_alloc(size, p_refill->p_upstream);
+	mtx_unlock(&p_refill->upstream_lock);
+	return p_chunk;
+}
+
+static void refill_upstream_free(void* p_memory, Refill* p_refill) {
+	if (p_refill->p_upstream == NULL) {
+		chunk_free(p_memory, NULL);
+		return;
+	}
+
+	mtx_lock(&p_refill->upstream_lock);
+	chunk_free(p_memory, p_refill->p_upstream);
+	mtx_unlock(&p_refill->upstream_lock);
+}
+
+// fills every empty slot with a new prefaulted chunk
+static void refill_fill_slots(Refill* p_refill) {
+	for (int i = 0; i < REFILL_SLOTS; ++i) {
+		if (atomic_load(&p_refill->ready[i]) != NULL) { continue; }
+
+		void* p_chunk = refill_upstream_alloc(p_refill->chunk_size, p_refill);
+		if (p_chunk == NULL) { return; }	// try again next time around
+		refill_prefault(p_chunk, p_refill->chunk_size);
+
+		void* p_expected = NULL;
+		if (!atomic_compare_exchange_strong(&p_refill->ready[i], &p_expected, p_chunk)) {
+			refill_upstream_free(p_chunk, p_refill);	// only this thread fills slots, so this shouldn't happen
+		}
+	}
+}
+
+static int refill_thread(void* arg) {
+	Refill* p_refill = arg;
+
+	while (atomic_load(&p_refill->running)) {
+		refill_fill_slots(p_refill);
+
+		// sleep until a chunk is taken. the timeout covers a wake up that lands between
+		// filling the slots and starting to wait
+		struct timespec until;
+		timespec_get(&until, TIME_UTC);
+		until.tv_nsec += REFILL_IDLE_MS * 1000000L;
+		if (until.tv_nsec >= 1000000000L) {
+			until.tv_sec++;
+			until.tv_nsec -= 1000000000L;
+		}
+
+		mtx_lock(&p_refill->lock);
+		if (atomic_load(&p_refill->running)) {
+			cnd_timedwait(&p_refill->wake, &p_refill->lock, &until);
+		}
+		mtx_unlock(&p_refill->lock);
+	}
+
+	return 0;
+}
+
+
+// chunk source callbacks
+
+// takes a ready chunk if one is big enough, and wakes the thread up to replace it
+// otherwise falls back to allocating from upstream on this thread
+static void* refill_source_alloc(const size_t size, void* p_context) {
+	Refill* p_refill = p_context;
+
+	if (size <= p_refill->chunk_size) {
+		for (int i = 0; i < REFILL_SLOTS; ++i) {
+			if (atomic_load_explicit(&p_refill->ready[i], memory_order_relaxed) == NULL) { continue; }
+
+			void* p_chunk = atomic_exchange(&p_refill->ready[i], NULL);
+			if (p_chunk != NULL) {
+				atomic_fetch_add_explicit(&p_refill->hits, 1, memory_order_relaxed);
+				cnd_signal(&p_refill->wake);
+				return p_chunk;
+			}
+		}
+	}
+
+	atomic_fetch_add_explicit(&p_refill->misses, 1, memory_order_relaxed);
+	cnd_signal(&p_refill->wake);
+	return refill_upstream_alloc(size, p_refill);
+}
+
+static void refill_source_free(void* p_memory, void* p_context) {
+	Refill* p_refill = p_context;
+	refill_upstream_free(p_memory, p_refill);
+}
+
+
+// starts a thread that keeps REFILL_SLOTS chunks of _chunk_size_ bytes from _p_upstream_ 
+// (NULL for malloc) ready for whatever allocates from p_refill->source
+REFILL_RESULT refill_create(const size_t chunk_size, const ChunkSource* p_upstream, Refill* p_refill) {
+	if (chunk_size == 0 || p_refill == NULL) {
+		return REFILL_INVALID_INPUT;
+	}
+
+	p_refill->source.p_alloc = refill_source_alloc;
+	p_refill->source.p_free = refill_source_free;
+	p_refill->source.p_context = p_refill;
+	p_refill->p_upstream = p_upstream;
+	p_refill->chunk_size = chunk_size;
+	for (int i = 0; i < REFILL_SLOTS; ++i) {
+		atomic_init(&p_refill->ready[i], NULL);
+	}
+	atomic_init(&p_refill->hits, 0);
+	atomic_init(&p_refill->misses, 0);
+	atomic_init(&p_refill->running, 1);
+
+	if (mtx_init(&p_refill->lock, mtx_plain) != thrd_success) {
+		return REFILL_FAILURE;
+	}
+	if (mtx_init(&p_refill->upstream_lock, mtx_plain) != thrd_success) {
+		mtx_destroy(&p_refill->lock);
+		return REFILL_FAILURE;
+	}
+	if (cnd_init(&p_refill->wake) != thrd_success) {
+		mtx_destroy(&p_refill->upstream_lock);
+		mtx_destroy(&p_refill->lock);
+		return REFILL_FAILURE;
+	}
+
+	// fill the slots once up front so the first allocations already hit
+	refill_fill_slots(p_refill);
+
+	if (thrd_create(&p_refill->thread, refill_thread, p_refill) != thrd_success) {
+		for (int i = 0; i < REFILL_SLOTS; ++i) {
+			refill_upstream_free(atomic_exchange(&p_refill->ready[i], NULL), p_refill);
+		}
+		cnd_destroy(&p_refill->wake);
+		mtx_destroy(&p_refill->upstream_lock);
+		mtx_destroy(&p_refill->lock);
+		return REFILL_FAILURE;
+	}
+
+	return REFILL_SUCCESS;
+}
+
+// stops the thread and frees the chunks nobody took
+// every pool using p_refill->source should be freed first
+void refill_free(Refill* p_refill) {
+	if (p_refill == NULL || !atomic_load(&p_refill->running)) { return; }
+
+	mtx_lock(&p_refill->lock);
+	atomic_store(&p_refill->running, 0);
+	cnd_signal(&p_refill->wake);
+	mtx_unlock(&p_refill->lock);
+
+	thrd_join(p_refill->thread, NULL);
+
+	for (int i = 0; i < REFILL_SLOTS; ++i) {
+		refill_upstream_free(atomic_exchange(&p_refill->ready[i], NULL), p_refill);
+	}
+
+	cnd_destroy(&p_refill->wake);
+	mtx_destroy(&p_refill->upstream_lock);
+	mtx_destroy(&p_refill->lock);
+}
@@ -0,0 +1,69 @@
+#ifndef REFILL_H
+#define REFILL_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <stdatomic.h>
+#include <threads.h>
+
+#include "Chunk.h"
+
+// This is a background refill thread for an allocator. When a pool runs out of room, 
+// pool_realloc -> pool_heap_create -> malloc happens right there on whatever thread overflowed it,
+// and every once in a while that malloc (plus the page faults from touching fresh memory) is slow.
+//
+// A Refill owns a thread that keeps REFILL_SLOTS chunks of chunk_size bytes allocated and 
+// prefaulted (every page touched) ahead of time. It is a chunk source (see Chunk.h), so a pool 
+// created with refill.source takes a ready chunk with one atomic exchange when it grows, and the 
+// thread is woken up to replace it. Only when no ready chunk is big enough does the allocating 
+// thread fall back to the upstream source itself. Chunks are published by the thread with a 
+// compare exchange into an empty slot, so neither side ever waits on the other for a chunk.
+//
+// Freed chunks go straight back to the upstream source.
+//
+// The thread and the pools' threads both call into the upstream source, so every call into a
+// custom upstream goes through upstream_lock (malloc/free don't need it, so they skip it). That makes sources that aren't thread safe themselves (like 
+// buddy.source) fine as upstreams, as long as nothing else uses them directly while the Refill is alive.
+//
+// The Refill can't be moved after refill_create (the thread and refill.source point at it), and 
+// it has to outlive every pool using it.
+//
+// Refill refill;
+// refill_create(sizeof(Pool) + POOL_SIZE_CAP, NULL, &refill);
+// Pool pool = pool_create_source(1024, &refill.source);
+// ...
+// pool_free(&pool);
+// refill_free(&refill);
+
+#define REFILL_SLOTS 2
+#define REFILL_PAGE_SIZE 4096
+#define REFILL_IDLE_MS 10			// how often the thread checks the slots without being woken
+
+typedef int REFILL_RESULT;
+enum {
+	REFILL_FAILURE,
+	REFILL_SUCCESS,
+	REFILL_INVALID_INPUT
+};
+
+typedef struct {
+	ChunkSource source;					// chunk source to hand to pools. takes ready chunks
+	const ChunkSource* p_upstream;		// where chunks really come from. NULL for malloc/free
+	size_t chunk_size;					// size of each ready chunk
+	_Atomic(void*) ready[REFILL_SLOTS];	// prefaulted chunks waiting to be taken. NULL if a slot is empty
+	atomic_size_t hits;					// allocations served from a ready chunk
+	atomic_size_t misses;				// allocations that had to go to the upstream source
+	atomic_int running;					// cleared by refill_free to stop the thread
+	thrd_t thread;
+	mtx_t lock;							// only used for sleeping/waking the thread
+	mtx_t upstream_lock;				// held around every call into p_upstream, when it isn't NULL
+	cnd_t wake;
+}Refill;
+
+REFILL_RESULT refill_create(const size_t chunk_size, const ChunkSource* p_upstream, Refill* p_refill);
+void refill_free(Refill* p_refill);
+
+#endif
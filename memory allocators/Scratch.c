@@ -0,0 +1,119 @@
+#include "Scratch.h"
+
+// each thread's scratch pools. Zeroed pools (p_start == NULL) get created on first use
+static thread_local Pool scratch_pools[SCRATCH_POOL_COUNT];
+static thread_local uint32_t scratch_depths[SCRATCH_POOL_COUNT];
+// the chunk each pool is allocating from. chunks after it are empty as far as scopes are concerned,
+// even if their p_current says otherwise; they get reset when allocation moves into them
+static thread_local Pool* scratch_tops[SCRATCH_POOL_COUNT];
+
+
+// returns true (1) if _p_pool_ is one of the _conflict_count_ pools in _pp_conflicts_
+static POOL_BOOL scratch_conflicts(const Pool* p_pool, Pool* const* pp_conflicts, const size_t conflict_count) {
+	for (size_t i = 0; i < conflict_count; ++i) {
+		if (pp_conflicts[i] == p_pool) {
+			return POOL_TRUE;
+		}
+	}
+	return POOL_FALSE;
+}
+
+// acquires a scope on one of the calling thread's scratch pools that isn't in _pp_conflicts_
+// returns SCRATCH_ERROR if every scratch pool conflicts, or a pool could not be created
+Scratch scratch_begin(Pool* const* pp_conflicts, const size_t conflict_count) {
+	for (uint32_t i = 0; i < SCRATCH_POOL_COUNT; ++i) {
+		Pool* p_pool = &scratch_pools[i];
+		if (scratch_conflicts(p_pool, pp_conflicts, conflict_count)) { continue; }
+
+		if (p_pool->p_start == NULL) {
+			Pool new_pool = pool_create(SCRATCH_POOL_SIZE);
+			if (new_pool.p_start == NULL) { return SCRATCH_ERROR; }
+			memcpy(p_pool, &new_pool, sizeof(Pool));	// size is const, so no normal assignment
+			scratch_tops[i] = p_pool;
+		}
+
+		Pool* p_chunk = scratch_tops[i];
+
+		return (Scratch) {
+			p_pool,					// p_pool
+			p_chunk,				// p_chunk
+			p_chunk->p_current,		// p_mark
+			scratch_depths[i]++		// depth
+		};
+	}
+
+	return SCRATCH_ERROR;
+}
+
+// returns the first chunk from the top chunk of _p_scratch_'s pool on with room for _alloc_size_,
+// chaining on a new chunk if none of them have room. NULL on failure
+// moving into a chunk empties it, since whatever is left in it is from scopes that already ended
+static Pool* scratch_find_capacity(const size_t alloc_size, Scratch* p_scratch) {
+	Pool** p_top = &scratch_tops[p_scratch->p_pool - scratch_pools];
+	Pool* p_chunk = *p_top;
+
+	while (1) {
+		size_t used = (char*)p_chunk->p_current - (char*)p_chunk->p_start;
+		if (p_chunk->size >= used + alloc_size) {
+			*p_top = p_chunk;
+			return p_chunk;
+		}
+		if (p_chunk->p_next == NULL) {
+			p_chunk = pool_realloc(alloc_size, p_chunk);
+			if (p_chunk != NULL) {
+				*p_top = p_chunk;
+			}
+			return p_chunk;
+		}
+		p_chunk = (Pool*)p_chunk->p_next;
+		p_chunk->p_current = (void*)p_chunk->p_start;
+	}
+}
+
+// allocates _alloc_size_ bytes in _p_scratch_'s scope, after its mark so scratch_end releases it
+// returns NULL on failure
+void* scratch_alloc_raw(const size_t alloc_size, Scratch* p_scratch) {
+	if (p_scratch == NULL || p_scratch->p_pool == NULL) { return NULL; }
+
+	Pool* p_chunk = scratch_find_capacity(alloc_size, p_scratch);
+	if (p_chunk == NULL) { return NULL; }
+
+	void* result = p_chunk->p_current;
+	p_chunk->p_current = (char*)p_chunk->p_current + alloc_size;
+
+	return result;
+}
+
+void* scratch_alloc(const void* data, const size_t alloc_size, Scratch* p_scratch) {
+	if (data == NULL) { return NULL; }
+
+	void* result = scratch_alloc_raw(alloc_size, p_scratch);
+	if (result == NULL) { return NULL; }
+
+	memcpy(result, data, alloc_size);
+	return result;
+}
+
+// releases everything allocated from _p_scratch_'s pool since the scope was acquired, in O(1)
+// the mark chunk becomes the top again, so the chunks after it count as empty (and aren't freed,
+// the next scope reuses them)
+void scratch_end(Scratch* p_scratch) {
+	if (p_scratch == NULL || p_scratch->p_pool == NULL) { return; }
+
+	ptrdiff_t index = p_scratch->p_pool - scratch_pools;
+	assert(scratch_depths[index] == p_scratch->depth + 1);	// scopes have to end in reverse order
+	scratch_depths[index] = p_scratch->depth;
+
+	p_scratch->p_chunk->p_current = p_scratch->p_mark;
+	scratch_tops[index] = p_scratch->p_chunk;
+
+	*p_scratch = SCRATCH_ERROR;
+}
+
+void scratch_thread_free() {
+	for (uint32_t i = 0; i < SCRATCH_POOL_COUNT; ++i) {
+		assert(scratch_depths[i] == 0);
+		pool_free(&scratch_pools[i]);
+		scratch_tops[i] = NULL;
+	}
+}
@@ -0,0 +1,68 @@
+#ifndef SCRATCH_H
+#define SCRATCH_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+#include <threads.h>
+
+#include "Pool.h"
+
+// These are thread local scratch arenas. They're for temporary memory that only needs to live
+// for the duration of a function call. Making a new Pool for that (pool_create -> malloc) costs
+// about as much as the mallocs it would replace, so instead every thread keeps a couple of pools
+// around and hands out "scopes" on them.
+//
+// A scope remembers where the pool ended when it was acquired (the chunk being allocated from and
+// its p_current). Everything allocated after that is released at once by scratch_end, which moves 
+// p_current back to the mark and makes the mark chunk the top chunk again, in O(1). Chunks after the
+// top are emptied lazily when an allocation moves into them, and kept around for the next scope, 
+// so after warming up a thread never mallocs for scratch memory.
+//
+// Scopes nest, but they have to be ended in the opposite order they were acquired in, like a stack.
+// 
+// Allocate from a scope with scratch_alloc_raw/scratch_alloc, not the pool functions on 
+// scratch.p_pool. pool_raw_alloc fills any earlier chunk that still has room, which can be before
+// the mark, and scratch_end would never give that memory back. The scratch versions only look at
+// the mark chunk and the ones after it:
+//
+// Scratch scratch = scratch_begin(NULL, 0);
+// float* p_temp = scratch_alloc_raw(sizeof(float) * 100, &scratch);
+// ...
+// scratch_end(&scratch);
+//
+// conflicts:
+// If a function takes a Pool* to put its results in, and that pool happens to be its caller's 
+// scratch pool, then using the same scratch pool for its temporaries would mean scratch_end throws 
+// away the results too (they were allocated after the mark). To avoid this, pass the pools you 
+// can't use to scratch_begin, and it picks a different one of the thread's SCRATCH_POOL_COUNT pools.
+//
+// Pool* build_thing(Pool* p_out) {
+//     Scratch scratch = scratch_begin(&p_out, 1);
+//     ... temporaries from scratch_alloc_raw(..., &scratch), results from p_out ...
+//     scratch_end(&scratch);
+// }
+
+#define SCRATCH_POOL_COUNT 2
+#define SCRATCH_POOL_SIZE POOL_SIZE_CAP
+
+typedef struct {
+	Pool* p_pool;			// pointer to the thread's scratch pool. NULL if scratch_begin failed
+	Pool* p_chunk;			// pointer to the chunk being allocated from when the scope was acquired
+	void* p_mark;			// p_current of p_chunk when the scope was acquired
+	uint32_t depth;			// how many scopes were already live on p_pool, for catching out of order ends
+}Scratch;
+
+#define SCRATCH_ERROR (Scratch){NULL, NULL, NULL, 0}
+
+Scratch scratch_begin(Pool* const* pp_conflicts, const size_t conflict_count);
+void* scratch_alloc_raw(const size_t alloc_size, Scratch* p_scratch);
+void* scratch_alloc(const void* data, const size_t alloc_size, Scratch* p_scratch);
+void scratch_end(Scratch* p_scratch);
+
+// frees the calling thread's scratch pools. Call before a thread exits, with no scopes live
+void scratch_thread_free();
+
+#endif
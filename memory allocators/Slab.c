@@ -1,6 +1,108 @@
 #include "Slab.h"
 
+#include <stdatomic.h>
+
+// color handed to the next colored frame. Rotates through SLAB_COLOR_COUNT colors so
+// consecutive frames start their slabs on different cache sets.
+static atomic_uint next_color = 0;
+
+
+// layout helpers:
+
+// returns the stride between slabs for a frame with _layout_
+// slabs are at least sizeof(void*) since available slabs store a pointer to the next one
+size_t frame_layout_slab_size(size_t slab_size, const FRAME_LAYOUT layout) {
+	if (slab_size < sizeof(void*)) {
+		slab_size = sizeof(void*);
+	}
+
+	if (layout & FRAME_LAYOUT_CACHE_ALIGNED) {
+		slab_size = (slab_size + SLAB_CACHE_LINE_SIZE - 1) & ~(size_t)(SLAB_CACHE_LINE_SIZE - 1);
+	}
+
+	return slab_size;
+}
+
+// returns how many bytes to allocate for _slab_count_ slabs of (already laid out) size _slab_size_
+// leaves slack for aligning the first slab and for the largest color
+size_t frame_layout_chunk_size(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout) {
+	size_t chunk_size = slab_size * slab_count;
+
+	if (layout & FRAME_LAYOUT_CACHE_ALIGNED) {
+		chunk_size += SLAB_CACHE_LINE_SIZE - 1;
+	}
+	if (layout & FRAME_LAYOUT_COLORED) {
+		chunk_size += SLAB_CACHE_LINE_SIZE * (SLAB_COLOR_COUNT - 1);
+	}
+
+	return chunk_size;
+}
+
+// returns the offset from _chunk_ where the first slab should go.
+// the first slab is always at least max_align_t aligned, since caller buffers (from_buffer) 
+// might not be. colored frames take the next color, so call this once per chunk
+size_t frame_layout_offset(const void* chunk, const FRAME_LAYOUT layout) {
+	size_t offset = 0;
+
+	uintptr_t misalignment = (uintptr_t)chunk & (_Alignof(max_align_t) - 1);
+	if (misalignment != 0) {
+		offset = _Alignof(max_align_t) - misalignment;
+	}
+	if (layout & FRAME_LAYOUT_CACHE_ALIGNED) {
+		offset = 0;
+		uintptr_t misalignment = (uintptr_t)chunk & (SLAB_CACHE_LINE_SIZE - 1);
+		if (misalignment != 0) {
+			offset = SLAB_CACHE_LINE_SIZE - misalignment;
+		}
+	}
+	if (layout & FRAME_LAYOUT_COLORED) {
+		unsigned color = atomic_fetch_add(&next_color, 1) % SLAB_COLOR_COUNT;
+		offset += (size_t)color * SLAB_CACHE_LINE_SIZE;
+	}
+
+	return offset;
+}
+
+// returns how many slabs of (already laid out) size _slab_size_ fit in _buffer_size_ bytes
+// when the first slab goes at _offset_
+uint32_t frame_layout_fit(const size_t buffer_size, const size_t slab_size, const size_t offset) {
+	if (offset >= buffer_size) { return 0; }
+
+	size_t count = (buffer_size - offset) / slab_size;
+	return count > UINT32_MAX ? UINT32_MAX : (uint32_t)count;
+}
+
+// set data in each slab to contain a pointer to the next available slab location
+void frame_layout_link(void* first, const size_t slab_size, const uint32_t slab_count) {
+	void* head = first;
+	for (size_t i = 0; i < slab_count - 1; ++i) {
+		void* next = (char*)head + slab_size;
+		*(void**)head = next;
+		head = next;
+	}
+	*(void**)head = NULL;
+}
+
+
+// frame creators:
+
 SLAB_RESULT frame_create(size_t slab_size, const uint32_t slab_count, Frame* frame) {
+	return frame_create_layout(slab_size, slab_count, FRAME_LAYOUT_PACKED, frame);
+}
+
+// same as frame_create, but lets you pick how slabs are laid out in the chunk (see FRAME_LAYOUT)
+//
+// Frame frame;
+// frame_create_layout(sizeof(int), 8, FRAME_LAYOUT_CACHE_ALIGNED | FRAME_LAYOUT_COLORED, &frame);
+SLAB_RESULT frame_create_layout(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, Frame* frame) {
+	return frame_create_source(slab_size, slab_count, layout, NULL, frame);
+}
+
+// same as frame_create_layout, but the chunk comes from _source_ instead of malloc
+//
+// Frame frame;
+// frame_create_source(sizeof(int), 8, FRAME_LAYOUT_PACKED, &buddy.source, &frame);
+SLAB_RESULT frame_create_source(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, const ChunkSource* source, Frame* frame) {
 
 	// so at the moment, this will not work for storing types that are smaller than 
 	// a pointer (such as a float), since a pointer to the next available slab is stored IN an 
@@ -11,26 +113,58 @@ SLAB_RESULT frame_create(size_t slab_size, const uint32_t slab_count, Frame* fra
 		return SLAB_INVALID_INPUT;
 	}
 
-	if (slab_size < sizeof(void*)) {
-		slab_size = sizeof(void*);
-	}
+	size_t stride = frame_layout_slab_size(slab_size, layout);
 
-	void* chunk = malloc(slab_size * slab_count);
+	void* chunk = chunk_alloc(frame_layout_chunk_size(stride, slab_count, layout), source);
 	if(chunk == NULL){ return SLAB_FAILURE; }
 
-	// set data in each slab to contain a pointer to the next available slab location
-	void* head = chunk;
-	for (size_t i = 0; i < slab_count - 1; ++i) {
-		void* next = (char*)head + slab_size;
-		*(void**)head = next;
-		head = next;
-	}
-	*(void**)head = NULL;
+	size_t offset = frame_layout_offset(chunk, layout);
+	frame_layout_link((char*)chunk + offset, stride, slab_count);
 
 	frame->start = chunk;
-	frame->available = chunk;
-	frame->slab_size = slab_size;
+	frame->available = (char*)chunk + offset;
+	frame->slab_size = stride;
+	frame->slab_count = slab_count;
+	frame->object_size = slab_size;
+	frame->offset = offset;
+	frame->layout = layout;
+	frame->source = source;
+	frame->borrowed = 0;
+
+	return SLAB_SUCCESS;
+}
+
+// makes a frame out of _buffer_size_ bytes of caller owned memory at _buffer_, with as many slabs
+// as fit after the layout's alignment/color offset. No heap allocation happens here, and 
+// frame_free doesn't free _buffer_. Frames never grow, so there's nothing to spill.
+// returns SLAB_INVALID_INPUT if not even one slab fits
+//
+// static char buffer[4096];
+// Frame frame;
+// frame_create_from_buffer(buffer, sizeof(buffer), sizeof(double), FRAME_LAYOUT_PACKED, &frame);
+SLAB_RESULT frame_create_from_buffer(void* buffer, const size_t buffer_size, const size_t slab_size, const FRAME_LAYOUT layout, Frame* frame) {
+	if (buffer == NULL || slab_size == 0 || frame == NULL) {
+		return SLAB_INVALID_INPUT;
+	}
+
+	size_t stride = frame_layout_slab_size(slab_size, layout);
+	size_t offset = frame_layout_offset(buffer, layout);
+	uint32_t slab_count = frame_layout_fit(buffer_size, stride, offset);
+	if (slab_count == 0) {
+		return SLAB_INVALID_INPUT;
+	}
+
+	frame_layout_link((char*)buffer + offset, stride, slab_count);
+
+	frame->start = buffer;
+	frame->available = (char*)buffer + offset;
+	frame->slab_size = stride;
 	frame->slab_count = slab_count;
+	frame->object_size = slab_size;
+	frame->offset = offset;
+	frame->layout = layout;
+	frame->source = NULL;
+	frame->borrowed = 1;
 
 	return SLAB_SUCCESS;
 }
@@ -58,7 +192,7 @@ void* slab_alloc(void* data, Frame* frame) {
 	void* slab = frame->available;
 	frame->available = *(void**)frame->available;
 
-	memcpy(slab, data, frame->slab_size);
+	memcpy(slab, data, frame->object_size);
 	return slab;
 }
 
@@ -93,10 +227,17 @@ void slab_free(void* location, Frame* frame) {
 void frame_free(Frame* frame) {
 	if(frame == NULL){ return; }
 
-	free(frame->start);
+	if (!frame->borrowed) {
+		chunk_free(frame->start, frame->source);
+	}
 
 	frame->start = NULL;
 	frame->available = NULL;
 	frame->slab_size = 0;
 	frame->slab_count = 0;
+	frame->object_size = 0;
+	frame->offset = 0;
+	frame->layout = FRAME_LAYOUT_PACKED;
+	frame->source = NULL;
+	frame->borrowed = 0;
 }
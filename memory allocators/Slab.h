@@ -6,6 +6,9 @@
 #include <string.h>
 #include <assert.h>
 #include <stdint.h>
+#include <stddef.h>
+
+#include "Chunk.h"
 
 // this is (what I think is) a slab allocator. It mallocs a large pool of memory (similar to a pool)
 // but divides it into equal-sized slabs. unused slabs make up a linked list, where each unused location
@@ -25,11 +28,38 @@
 //    | instead of a void*. This makes it less user friendly I think, since you would have to go through a slab
 //    | struct instead of just the value directly.
 
+// layout options for frames. These can be or'd together and passed to frame_create_layout.
+// 
+// FRAME_LAYOUT_PACKED is the original layout, slabs are placed back to back starting at the
+// start of the chunk. Slabs smaller than a cache line end up sharing lines, so two threads
+// updating neighbouring slabs fight over the same line (false sharing).
+// 
+// FRAME_LAYOUT_CACHE_ALIGNED rounds every slab up to a multiple of SLAB_CACHE_LINE_SIZE and
+// aligns the first slab to a cache line, so no two slabs ever share a line. Costs memory for
+// small slabs.
+// 
+// FRAME_LAYOUT_COLORED shifts the first slab by a "color" (a multiple of SLAB_CACHE_LINE_SIZE)
+// that rotates every time a frame is created. Without it, every frame with the same slab size
+// lines its slabs up on the same cache sets, so they evict each other.
+#define SLAB_CACHE_LINE_SIZE 64
+#define SLAB_COLOR_COUNT 8
+
+typedef enum {
+	FRAME_LAYOUT_PACKED = 0,
+	FRAME_LAYOUT_CACHE_ALIGNED = 1 << 0,
+	FRAME_LAYOUT_COLORED = 1 << 1
+}FRAME_LAYOUT;
+
 typedef struct {
 	void* start;					// pointer to the full chunk of memory
 	void* available;				// pointer to an available chunk 
-	size_t slab_size;				// size of each slab in the frame
+	size_t slab_size;				// size of each slab in the frame (the stride between slabs)
 	uint32_t slab_count;			// number of slabs in the frame
+	size_t object_size;				// size the frame was asked for. <= slab_size, what slab_alloc copies
+	size_t offset;					// offset of the first slab from start (alignment + color)
+	FRAME_LAYOUT layout;			// layout flags the frame was created with
+	const ChunkSource* source;		// where the chunk came from. NULL for malloc/free
+	uint8_t borrowed;				// 1 if start is caller memory (frame_create_from_buffer), frame_free leaves it alone
 }Frame;
 
 #define FRAME_ERROR (Frame) { NULL, 0, 0, NULL };
@@ -43,6 +73,16 @@ typedef int SLAB_RESULT;
 //static Slab* slab_list_create(void* memory, size_t slab_size, uint32_t slab_count);
 
 SLAB_RESULT frame_create(const size_t slab_size, const uint32_t slab_count, Frame* frame);
+SLAB_RESULT frame_create_layout(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, Frame* frame);
+SLAB_RESULT frame_create_source(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, const ChunkSource* source, Frame* frame);
+SLAB_RESULT frame_create_from_buffer(void* buffer, const size_t buffer_size, const size_t slab_size, const FRAME_LAYOUT layout, Frame* frame);
+
+// layout helpers, shared with Frame_s
+size_t frame_layout_slab_size(size_t slab_size, const FRAME_LAYOUT layout);
+size_t frame_layout_chunk_size(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout);
+size_t frame_layout_offset(const void* chunk, const FRAME_LAYOUT layout);
+uint32_t frame_layout_fit(const size_t buffer_size, const size_t slab_size, const size_t offset);
+void frame_layout_link(void* first, const size_t slab_size, const uint32_t slab_count);
 
 void* slab_alloc_raw(Frame* frame);
 void* slab_alloc(void* data, Frame* frame);
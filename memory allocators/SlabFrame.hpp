@@ -0,0 +1,91 @@
+#ifndef SLAB_FRAME_HPP
+#define SLAB_FRAME_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+#include <new>
+#include <utility>
+
+// C++ version of FRAME_DECLARE (Slab_t.h). SlabFrame<T, N> holds N slabs of T inline, so the slab 
+// size, alignment and count are all constants and there's no malloc. Put it in static storage, on
+// the stack, or as a member. Unlike the C version, alloc constructs the T in place and free runs
+// its destructor.
+//
+// static SlabFrame<Particle, 1024> particles;
+// Particle* p_a = particles.alloc(1.0f, 2.0f);
+// particles.free(p_a);
+
+template <typename T, std::size_t N>
+class SlabFrame {
+	static_assert(N > 0, "a SlabFrame needs at least one slab");
+	static_assert(N <= UINT32_MAX, "slab count has to fit in a uint32_t");
+
+	union Slab {
+		alignas(T) unsigned char storage[sizeof(T)];
+		Slab* p_next;						// next available slab while the slab is free
+	};
+
+	Slab slabs[N];							// the slabs themselves, no malloc
+	Slab* p_available = nullptr;			// freed slabs. nullptr if there are none
+	std::uint32_t unused = 0;				// slabs at this index and up have never been used
+
+public:
+	static constexpr std::size_t slab_size = sizeof(Slab);
+	static constexpr std::size_t slab_count = N;
+
+	SlabFrame() = default;
+	SlabFrame(const SlabFrame&) = delete;				// live objects would be copied as raw bytes
+	SlabFrame& operator=(const SlabFrame&) = delete;
+
+	// returns uninitialized memory for a T, or nullptr when the frame is full
+	T* alloc_raw() noexcept {
+		if (p_available != nullptr) {
+			Slab* p_slab = p_available;
+			p_available = p_slab->p_next;
+			return reinterpret_cast<T*>(p_slab->storage);
+		}
+		if (unused < N) {
+			return reinterpret_cast<T*>(slabs[unused++].storage);
+		}
+		return nullptr;
+	}
+
+	// constructs a T from _args_ in a free slab. returns nullptr when the frame is full
+	template <typename... Args>
+	T* alloc(Args&&... args) {
+		T* p_slab = alloc_raw();
+		if (p_slab == nullptr) {
+			return nullptr;
+		}
+		return ::new (static_cast<void*>(p_slab)) T(std::forward<Args>(args)...);
+	}
+
+	// destroys the T at _p_location_ and gives its slab back to the frame
+	void free(T* p_location) noexcept {
+		if (p_location == nullptr) { return; }
+		assert(owns(p_location));
+
+		p_location->~T();
+
+		Slab* p_slab = reinterpret_cast<Slab*>(p_location);
+		p_slab->p_next = p_available;
+		p_available = p_slab;
+	}
+
+	// returns true if _p_location_ is one of this frame's slabs that has been handed out before
+	bool owns(const T* p_location) const noexcept {
+		const Slab* p_slab = reinterpret_cast<const Slab*>(p_location);
+		return p_slab >= slabs && p_slab < slabs + unused;
+	}
+
+	std::uint32_t count_available() const noexcept {
+		std::uint32_t available = static_cast<std::uint32_t>(N) - unused;
+		for (const Slab* p_slab = p_available; p_slab != nullptr; p_slab = p_slab->p_next) {
+			available++;
+		}
+		return available;
+	}
+};
+
+#endif
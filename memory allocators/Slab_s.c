@@ -1,10 +1,32 @@
+#ifndef _WIN32
+#define _DEFAULT_SOURCE		// madvise, which strict C modes hide
+#endif
+
 #include "Slab_s.h"
 
+#ifdef _WIN32
+#define WIN32_LEAN_AND_MEAN
+#include <windows.h>
+#else
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
 //	typedef struct {
 //		void* start;					// pointer to the full chunk of memory
 //		void* available;				// pointer to an available chunk 
-//		size_t slab_size;				// size of each slab in the frame
+//		size_t slab_size;				// size of each slab in the frame (the stride between slabs)
 //		uint32_t slab_count;			// number of slabs in the frame
+//		size_t offset;					// offset of the first slab from start (alignment + color)
+//		FRAME_LAYOUT layout;			// layout flags the frame was created with
+//		uint8_t borrowed;				// 1 if start is caller memory (frame_s_create_from_buffer), frame_s_free leaves it alone
+//		struct Slab_s** owners;			// handle table, the Slab_s holding each slot. NULL unless frame_s_track_handles
+//		void** previous;				// previous slab on the available list for each slot. NULL unless frame_s_track_handles
+//		void* available_last;			// last slab on the available list. only kept up to date with handle tracking on
+//		void* held;						// free slabs at or above held_from, kept out of the way of a compaction
+//		void* held_last;				// last slab on the held list
+//		uint32_t held_from;				// first held slot. slab_count when nothing is held
+//		uint32_t held_count;			// number of slabs on the held list
 //		mtx_t lock;						// mutex for thread safety
 //	}Frame_s;
 //
@@ -19,7 +41,121 @@ void print_void_ptr(void* a) {
 }
 
 
+// available list helpers. These all expect frame->lock to be held.
+// with handle tracking on, they keep frame->previous up to date too
+
+static uint32_t frame_s_slot(const void* memory, const Frame_s* frame) {
+	return (uint32_t)(((char*)memory - ((char*)frame->start + frame->offset)) / frame->slab_size);
+}
+
+static void* frame_s_slot_memory(const uint32_t slot, const Frame_s* frame) {
+	return (char*)frame->start + frame->offset + (size_t)slot * frame->slab_size;
+}
+
+// with handle tracking on, free slots at or above held_from sit on a second list, frame->held,
+// instead of frame->available. Compaction moves its high cursor down by holding the slots it passes, 
+// so nothing gets allocated up there while it's emptying the top. held_from is slab_count otherwise
+
+static uint8_t frame_s_is_held(const void* memory, const Frame_s* frame) {
+	return frame->previous != NULL && frame_s_slot(memory, frame) >= frame->held_from;
+}
+
+// pushes _memory_ onto the front of the list at _head_/_last_
+static void frame_s_push(void* memory, void** head, void** last, Frame_s* frame) {
+	*(void**)memory = *head;
+	if (frame->previous != NULL) {
+		frame->previous[frame_s_slot(memory, frame)] = NULL;
+		if (*head != NULL) {
+			frame->previous[frame_s_slot(*head, frame)] = memory;
+		}
+		else {
+			*last = memory;
+		}
+	}
+	*head = memory;
+}
+
+// pops the front of the list at _head_/_last_. NULL if it's empty
+static void* frame_s_pop(void** head, void** last, Frame_s* frame) {
+	void* memory = *head;
+	if (memory == NULL) { return NULL; }
+
+	*head = *(void**)memory;
+	if (frame->previous != NULL) {
+		if (*head != NULL) {
+			frame->previous[frame_s_slot(*head, frame)] = NULL;
+		}
+		else {
+			*last = NULL;
+		}
+	}
+
+	return memory;
+}
+
+// takes an available slab. held slabs are only handed out once nothing else is left, since
+// memory is more important than finishing a compaction. NULL if there are none
+static void* frame_s_take(Frame_s* frame) {
+	void* memory = frame_s_pop(&frame->available, &frame->available_last, frame);
+	if (memory == NULL && frame->held != NULL) {
+		memory = frame_s_pop(&frame->held, &frame->held_last, frame);
+		frame->held_count--;
+	}
+	return memory;
+}
+
+// gives _memory_ back to whichever list its slot belongs on
+static void frame_s_give(void* memory, Frame_s* frame) {
+	if (frame_s_is_held(memory, frame)) {
+		frame_s_push(memory, &frame->held, &frame->held_last, frame);
+		frame->held_count++;
+	}
+	else {
+		frame_s_push(memory, &frame->available, &frame->available_last, frame);
+	}
+}
+
+// removes the free slab _memory_ from wherever it is in its list. only works with handle tracking on
+static void frame_s_unlink(void* memory, Frame_s* frame) {
+	void** head = &frame->available;
+	void** last = &frame->available_last;
+	if (frame_s_is_held(memory, frame)) {
+		head = &frame->held;
+		last = &frame->held_last;
+		frame->held_count--;
+	}
+
+	void* previous = frame->previous[frame_s_slot(memory, frame)];
+	void* next = *(void**)memory;
+
+	if (previous == NULL) {
+		*head = next;
+	}
+	else {
+		*(void**)previous = next;
+	}
+	if (next != NULL) {
+		frame->previous[frame_s_slot(next, frame)] = previous;
+	}
+	else {
+		*last = previous;
+	}
+}
+
+// records which Slab_s holds _memory_ (NULL when it's freed), if handle tracking is on
+static void frame_s_set_owner(const void* memory, Slab_s* slab, Frame_s* frame) {
+	if (frame->owners != NULL) {
+		frame->owners[frame_s_slot(memory, frame)] = slab;
+	}
+}
+
+
 SLAB_S_RESULT frame_s_create(size_t slab_size, const uint32_t slab_count, Frame_s* frame) {
+	return frame_s_create_layout(slab_size, slab_count, FRAME_LAYOUT_PACKED, frame);
+}
+
+// same as frame_s_create, but lets you pick how slabs are laid out in the chunk (see FRAME_LAYOUT in Slab.h)
+SLAB_S_RESULT frame_s_create_layout(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, Frame_s* frame) {
 
 	if (slab_size == 0|| slab_count == 0 || frame == NULL) {
 		return SLAB_S_INVALID_INPUT;
@@ -27,29 +163,69 @@ SLAB_S_RESULT frame_s_create(size_t slab_size, const uint32_t slab_count, Frame_
 
 	// for now, the minimum slab size is sizeof(void*). In the future, maybe use int offset
 	// in the case that slab_size is smaller in order to save space?
-	if (slab_size < sizeof(void*)) {
-		slab_size = sizeof(void*);
-	}
+	size_t stride = frame_layout_slab_size(slab_size, layout);
 
-	void* chunk = malloc(slab_size * slab_count);
+	void* chunk = malloc(frame_layout_chunk_size(stride, slab_count, layout));
 	if(chunk == NULL){ return SLAB_S_FAILURE; }
 
-	// set data in each slab to contain a pointer to the next available slab location
-	void* head = chunk;
-	for (uint32_t i = 0; i < slab_count - 1; ++i) {
-		void* next = (char*)head + slab_size;
-		*(void**)head = next;
-		head = next;
-	}
-	*(void**)head = NULL;
+	size_t offset = frame_layout_offset(chunk, layout);
+	frame_layout_link((char*)chunk + offset, stride, slab_count);
 
 	mtx_t lock;
 	mtx_init(&lock, mtx_plain);
 
 	frame->start = chunk;
-	frame->available = chunk;
-	frame->slab_size = slab_size;
+	frame->available = (char*)chunk + offset;
+	frame->slab_size = stride;
 	frame->slab_count = slab_count;
+	frame->offset = offset;
+	frame->layout = layout;
+	frame->borrowed = 0;
+	frame->owners = NULL;
+	frame->previous = NULL;
+	frame->available_last = NULL;
+	frame->held = NULL;
+	frame->held_last = NULL;
+	frame->held_from = slab_count;
+	frame->held_count = 0;
+	frame->lock = lock;
+
+	return SLAB_S_SUCCESS;
+}
+
+// makes a Frame_s out of _buffer_size_ bytes of caller owned memory at _buffer_, with as many slabs
+// as fit. No heap allocation, and frame_s_free doesn't free _buffer_ (see frame_create_from_buffer)
+SLAB_S_RESULT frame_s_create_from_buffer(void* buffer, const size_t buffer_size, const size_t slab_size, const FRAME_LAYOUT layout, Frame_s* frame) {
+	if (buffer == NULL || slab_size == 0 || frame == NULL) {
+		return SLAB_S_INVALID_INPUT;
+	}
+
+	size_t stride = frame_layout_slab_size(slab_size, layout);
+	size_t offset = frame_layout_offset(buffer, layout);
+	uint32_t slab_count = frame_layout_fit(buffer_size, stride, offset);
+	if (slab_count == 0) {
+		return SLAB_S_INVALID_INPUT;
+	}
+
+	frame_layout_link((char*)buffer + offset, stride, slab_count);
+
+	mtx_t lock;
+	mtx_init(&lock, mtx_plain);
+
+	frame->start = buffer;
+	frame->available = (char*)buffer + offset;
+	frame->slab_size = stride;
+	frame->slab_count = slab_count;
+	frame->offset = offset;
+	frame->layout = layout;
+	frame->borrowed = 1;
+	frame->owners = NULL;
+	frame->previous = NULL;
+	frame->available_last = NULL;
+	frame->held = NULL;
+	frame->held_last = NULL;
+	frame->held_from = slab_count;
+	frame->held_count = 0;
 	frame->lock = lock;
 
 	return SLAB_S_SUCCESS;
@@ -74,9 +250,8 @@ SLAB_S_RESULT slab_s_alloc_raw(Slab_s* slab, Frame_s* frame) {
 		return SLAB_S_FAILURE;
 	}
 
-	slab->memory = frame->available;
-	frame->available = *(void**)frame->available;
-	
+	slab->memory = frame_s_take(frame);
+	frame_s_set_owner(slab->memory, slab, frame);
 
 	mtx_unlock(&frame->lock);
 	return SLAB_S_SUCCESS;
@@ -93,10 +268,10 @@ SLAB_S_RESULT slab_s_alloc(void* data, Slab_s* slab, Frame_s* frame) {
 		return SLAB_S_FAILURE;
 	}
 
-	slab->memory = frame->available;
-	frame->available = *(void**)frame->available;
+	slab->memory = frame_s_take(frame);
+	frame_s_set_owner(slab->memory, slab, frame);
 
-	memcpy(slab->memory, data, frame->slab_size);
+	memcpy(slab->memory, data, slab->memory_size); // slab_size may be padded past the data
 
 	mtx_unlock(&frame->lock);
 	return SLAB_S_SUCCESS;
@@ -132,8 +307,8 @@ SLAB_S_RESULT slab_s_free(Slab_s* slab, Frame_s* frame) {
 	// zeroing out the old memory is probably optional and slower, but safer, so
 	memset(slab->memory, 0, frame->slab_size);
 
-	*(void**)slab->memory = frame->available;
-	frame->available = slab->memory;
+	frame_s_set_owner(slab->memory, NULL, frame);
+	frame_s_give(slab->memory, frame);
 
 	slab->memory = NULL;
 	slab->memory_size = 0;
@@ -142,16 +317,249 @@ SLAB_S_RESULT slab_s_free(Slab_s* slab, Frame_s* frame) {
 	return SLAB_S_SUCCESS;
 }
 
+// same as slab_s_free for _slab_count_ slabs at once, but only takes the lock once
+SLAB_S_RESULT slab_s_free_batch(Slab_s* slabs, const size_t slab_count, Frame_s* frame) {
+	if(frame == NULL || slabs == NULL) { return SLAB_S_INVALID_INPUT; }
+
+	mtx_lock(&frame->lock);
+
+	for (size_t i = 0; i < slab_count; ++i) {
+		if (slabs[i].memory == NULL) { continue; }
+
+		memset(slabs[i].memory, 0, frame->slab_size);
+
+		frame_s_set_owner(slabs[i].memory, NULL, frame);
+		frame_s_give(slabs[i].memory, frame);
+
+		slabs[i].memory = NULL;
+		slabs[i].memory_size = 0;
+	}
+
+	mtx_unlock(&frame->lock);
+	return SLAB_S_SUCCESS;
+}
+
+// compaction:
+
+// turns on the handle table and the previous slab table for _frame_ (see the top of Slab_s.h)
+// has to be called while no slabs are allocated
+// returns SLAB_S_INVALID_INPUT if some are, or tracking is already on
+SLAB_S_RESULT frame_s_track_handles(Frame_s* frame) {
+	if (frame == NULL || frame->start == NULL) { return SLAB_S_INVALID_INPUT; }
+
+	mtx_lock(&frame->lock);
+
+	uint32_t available = 0;
+	for (void* slab = frame->available; slab != NULL; slab = *(void**)slab) {
+		available++;
+	}
+	if (frame->owners != NULL || available != frame->slab_count) {
+		mtx_unlock(&frame->lock);
+		return SLAB_S_INVALID_INPUT;
+	}
+
+	frame->owners = calloc(frame->slab_count, sizeof(Slab_s*));
+	frame->previous = calloc(frame->slab_count, sizeof(void*));
+	if (frame->owners == NULL || frame->previous == NULL) {
+		free(frame->owners);
+		free(frame->previous);
+		frame->owners = NULL;
+		frame->previous = NULL;
+		mtx_unlock(&frame->lock);
+		return SLAB_S_FAILURE;
+	}
+
+	void* previous = NULL;
+	for (void* slab = frame->available; slab != NULL; slab = *(void**)slab) {
+		frame->previous[frame_s_slot(slab, frame)] = previous;
+		previous = slab;
+	}
+	frame->available_last = previous;
+
+	mtx_unlock(&frame->lock);
+	return SLAB_S_SUCCESS;
+}
+
+// starts a compaction of _frame_, which needs handle tracking on.
+// anything held by an earlier compaction goes back on the available list first
+SLAB_S_RESULT frame_s_compact_begin(FrameCompact_s* compact, Frame_s* frame) {
+	if (compact == NULL || frame == NULL || frame->owners == NULL) { return SLAB_S_INVALID_INPUT; }
+
+	mtx_lock(&frame->lock);
+
+	// splice the held list onto the back of the available list
+	if (frame->held != NULL) {
+		frame->previous[frame_s_slot(frame->held, frame)] = frame->available_last;
+		if (frame->available_last == NULL) {
+			frame->available = frame->held;
+		}
+		else {
+			*(void**)frame->available_last = frame->held;
+		}
+		frame->available_last = frame->held_last;
+	}
+	frame->held = NULL;
+	frame->held_last = NULL;
+	frame->held_count = 0;
+	frame->held_from = frame->slab_count;
+
+	compact->low = 0;
+	compact->high = frame->slab_count;
+	compact->moved = 0;
+
+	mtx_unlock(&frame->lock);
+	return SLAB_S_SUCCESS;
+}
+
+// moves live slabs from the top of _frame_ into free slots at the bottom, and points their Slab_s
+// at the new spot. looks at or moves at most _budget_ slabs before letting go of the lock
+// every slot the top cursor passes is held, so allocations in between steps stay below it
+// returns SLAB_S_IN_PROGRESS if there's more to do, SLAB_S_SUCCESS once every live slab is packed
+// at the bottom.
+//
+// FrameCompact_s compact;
+// frame_s_compact_begin(&compact, &frame);
+// while (frame_s_compact_step(64, &compact, &frame) == SLAB_S_IN_PROGRESS) {
+//     ... handle requests ...
+// }
+// frame_s_release_tail(&frame);
+SLAB_S_RESULT frame_s_compact_step(const uint32_t budget, FrameCompact_s* compact, Frame_s* frame) {
+	if (compact == NULL || frame == NULL || frame->owners == NULL || budget == 0) { return SLAB_S_INVALID_INPUT; }
+
+	mtx_lock(&frame->lock);
+
+	// the frame could have had its tail released since the last step
+	if (compact->high > frame->slab_count) {
+		compact->high = frame->slab_count;
+	}
+
+	uint32_t work = 0;
+	while (work < budget) {
+		// other threads can free and allocate below high between steps, so low is only a hint,
+		// and everything is checked again here
+		if (compact->low >= compact->high) {
+			mtx_unlock(&frame->lock);
+			return SLAB_S_SUCCESS;
+		}
+
+		uint32_t top = compact->high - 1;
+		if (frame->owners[top] == NULL) {
+			void* memory = frame_s_slot_memory(top, frame);
+			frame_s_unlink(memory, frame);
+			frame->held_from = top;
+			frame_s_give(memory, frame);
+
+			compact->high = top;
+			work++;
+			continue;
+		}
+		if (frame->owners[compact->low] != NULL) {
+			compact->low++;
+			work++;
+			continue;
+		}
+
+		// low is free and top isn't, so low < top here
+		void* source = frame_s_slot_memory(top, frame);
+		void* destination = frame_s_slot_memory(compact->low, frame);
+		Slab_s* owner = frame->owners[top];
+
+		frame_s_unlink(destination, frame);
+		memcpy(destination, source, frame->slab_size);
+		owner->memory = destination;
+		frame->owners[compact->low] = owner;
+		frame->owners[top] = NULL;
+
+		memset(source, 0, frame->slab_size);
+		frame->held_from = top;
+		frame_s_give(source, frame);
+
+		compact->low++;
+		compact->high = top;
+		compact->moved++;
+		work++;
+	}
+
+	mtx_unlock(&frame->lock);
+	return SLAB_S_IN_PROGRESS;
+}
+
+// cuts the frame off where the last compaction's top cursor got to, by dropping the whole held 
+// list at once. The pages in the tail are handed back to the OS after the lock is let go (the 
+// virtual memory stays until frame_s_free).
+// returns how many slots were released, 0 if nothing is held or a slab was allocated from the 
+// held slots in the meantime (the frame ran out of other slabs, compact again later)
+uint32_t frame_s_release_tail(Frame_s* frame) {
+	if (frame == NULL || frame->owners == NULL) { return 0; }
+
+	mtx_lock(&frame->lock);
+
+	uint32_t released = frame->held_count;
+	if (released == 0 || released != frame->slab_count - frame->held_from) {
+		mtx_unlock(&frame->lock);
+		return 0;
+	}
+
+	uintptr_t tail_start = (uintptr_t)frame_s_slot_memory(frame->held_from, frame);
+	uintptr_t tail_end = (uintptr_t)frame_s_slot_memory(frame->slab_count, frame);
+
+	frame->held = NULL;
+	frame->held_last = NULL;
+	frame->held_count = 0;
+	frame->slab_count = frame->held_from;
+
+	uint8_t borrowed = frame->borrowed;
+	mtx_unlock(&frame->lock);
+
+	// nothing can reach the tail anymore, so this doesn't need the lock
+	if (!borrowed) {
+		// only whole pages inside the tail can go
+#ifdef _WIN32
+		SYSTEM_INFO info;
+		GetSystemInfo(&info);
+		uintptr_t page_size = info.dwPageSize;
+#else
+		uintptr_t page_size = (uintptr_t)sysconf(_SC_PAGESIZE);
+#endif
+		uintptr_t first_page = (tail_start + page_size - 1) & ~(page_size - 1);
+		uintptr_t last_page = tail_end & ~(page_size - 1);
+
+		if (first_page < last_page) {
+#ifdef _WIN32
+			VirtualAlloc((void*)first_page, last_page - first_page, MEM_RESET, PAGE_READWRITE);
+#else
+			madvise((void*)first_page, last_page - first_page, MADV_DONTNEED);
+#endif
+		}
+	}
+
+	return released;
+}
+
 void frame_s_free(Frame_s* frame) {
 	if(frame == NULL){ return; }
 	mtx_lock(&frame->lock); // a frame should not be touched after frame_s_free is called
 
-	free(frame->start);
+	if (!frame->borrowed) {
+		free(frame->start);
+	}
 
 	frame->start = NULL;
 	frame->available = NULL;
 	frame->slab_size = 0;
 	frame->slab_count = 0;
+	frame->offset = 0;
+	frame->borrowed = 0;
+
+	free(frame->owners);
+	free(frame->previous);
+	frame->owners = NULL;
+	frame->previous = NULL;
+	frame->available_last = NULL;
+	frame->held = NULL;
+	frame->held_last = NULL;
+	frame->held_from = 0;
+	frame->held_count = 0;
 
 	mtx_unlock(&frame->lock);
 	mtx_destroy(&frame->lock);
@@ -8,6 +8,8 @@
 #include <stdint.h>
 #include <threads.h>
 
+#include "Slab.h"	// FRAME_LAYOUT and the layout helpers
+
 // This is the (hopefully) safer version of the simple slab allocator. It implements a struct that 
 // contains memory allocated from the Frame_s. This struct is what is taken as a parameter for 
 // memory related operations, which prevents errors with passing in pointers to memory that is not
@@ -22,21 +24,56 @@
 //
 // for simplicity sake, any time frame->available is accessed, or a frame's values are influenced, 
 // a lock should be used so only one thread can access the frame at a time.
+//
+// if several threads each keep updating their own slab, create the frame with 
+// FRAME_LAYOUT_CACHE_ALIGNED (frame_s_create_layout) so neighbouring slabs don't share a cache line.
+//
+// compaction:
+// since users hold a Slab_s instead of a raw pointer, the frame is allowed to move slabs around.
+// After frame_s_track_handles, the frame keeps a handle table that maps every slot to the Slab_s 
+// that holds it (so a Slab_s must stay at the same address while it holds a slab), plus the 
+// previous slab on the available list for every slot, so any free slab can be unlinked in O(1).
+// frame_s_compact_step then moves live slabs from the top of the frame into free slots at the 
+// bottom and updates each moved Slab_s's memory. It does at most _budget_ units of work (slots
+// looked at + slabs moved) per call while holding the lock, so the pause is bounded and other 
+// threads can use the frame in between steps. Free slots above its top cursor are held on a 
+// separate list, so allocations in between steps land below it. Once it's done, 
+// frame_s_release_tail drops the held list, which cuts the frame down to the last live slab, 
+// and gives the physical memory of the tail back to the OS. Every call is O(budget) or O(1).
+// Don't read through slab.memory while a step runs, and read it again after every step.
+// Compaction can't be combined with Epoch, since a lock free reader could be reading a slab as it moves.
 
 
 typedef struct {
 	void* start;					// pointer to the full chunk of memory
 	void* available;				// pointer to an available chunk 
-	size_t slab_size;				// size of each slab in the frame
+	size_t slab_size;				// size of each slab in the frame (the stride between slabs)
 	uint32_t slab_count;			// number of slabs in the frame
+	size_t offset;					// offset of the first slab from start (alignment + color)
+	FRAME_LAYOUT layout;			// layout flags the frame was created with
+	uint8_t borrowed;				// 1 if start is caller memory (frame_s_create_from_buffer), frame_s_free leaves it alone
+	struct Slab_s** owners;			// handle table, the Slab_s holding each slot. NULL unless frame_s_track_handles
+	void** previous;				// previous slab on the available list for each slot. NULL unless frame_s_track_handles
+	void* available_last;			// last slab on the available list. only kept up to date with handle tracking on
+	void* held;						// free slabs at or above held_from, kept out of the way of a compaction
+	void* held_last;				// last slab on the held list
+	uint32_t held_from;				// first held slot. slab_count when nothing is held
+	uint32_t held_count;			// number of slabs on the held list
 	mtx_t lock;						// mutex for thread safety
 }Frame_s;
 
-typedef struct {
+typedef struct Slab_s {
 	void* memory;					// where the data is stored
 	size_t memory_size;				// how big the data is
 }Slab_s;
 
+// where an incremental compaction is up to. slots below low are live, slots at or above high are held
+typedef struct {
+	uint32_t low;
+	uint32_t high;
+	uint32_t moved;					// slabs moved so far
+}FrameCompact_s;
+
 #define FRAME_S_ERROR (Frame_s) { NULL, 0, 0, NULL };
 
 typedef int SLAB_S_RESULT;
@@ -46,12 +83,15 @@ typedef int SLAB_S_RESULT;
 enum {
 	SLAB_S_FAILURE,
 	SLAB_S_SUCCESS,
-	SLAB_S_INVALID_INPUT
+	SLAB_S_INVALID_INPUT,
+	SLAB_S_IN_PROGRESS				// frame_s_compact_step ran out of budget before finishing
 };
 
 void print_void_ptr(void* a);
 
 SLAB_S_RESULT frame_s_create(const size_t slab_size, const uint32_t slab_count, Frame_s* frame);
+SLAB_S_RESULT frame_s_create_layout(const size_t slab_size, const uint32_t slab_count, const FRAME_LAYOUT layout, Frame_s* frame);
+SLAB_S_RESULT frame_s_create_from_buffer(void* buffer, const size_t buffer_size, const size_t slab_size, const FRAME_LAYOUT layout, Frame_s* frame);
 
 SLAB_S_RESULT slab_s_alloc_raw(Slab_s* slab, Frame_s* frame);
 SLAB_S_RESULT slab_s_alloc(void* data, Slab_s* slab, Frame_s* frame);
@@ -59,6 +99,12 @@ SLAB_S_RESULT slab_s_alloc(void* data, Slab_s* slab, Frame_s* frame);
 uint32_t count_s_available_slabs(Frame_s* frame);
 
 SLAB_S_RESULT slab_s_free(Slab_s* slab, Frame_s* frame);
+SLAB_S_RESULT slab_s_free_batch(Slab_s* slabs, const size_t slab_count, Frame_s* frame);
+
+SLAB_S_RESULT frame_s_track_handles(Frame_s* frame);
+SLAB_S_RESULT frame_s_compact_begin(FrameCompact_s* compact, Frame_s* frame);
+SLAB_S_RESULT frame_s_compact_step(const uint32_t budget, FrameCompact_s* compact, Frame_s* frame);
+uint32_t frame_s_release_tail(Frame_s* frame);
 
 void frame_s_free(Frame_s* frame);
 
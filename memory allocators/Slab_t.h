@@ -0,0 +1,86 @@
+#ifndef SLAB_T_H
+#define SLAB_T_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+// This is the typed version of the slab allocator. Frame keeps slab_size and slab_count at runtime,
+// so every alloc goes through a void* and reads its sizes out of the struct. FRAME_DECLARE instead
+// generates a frame type and functions for one type and slab count, so the size, alignment and 
+// stride are all compile time constants, the functions can be inlined completely, and you get 
+// typed pointers back.
+//
+// The slabs live inside the frame struct itself, so there is no malloc at all. Put the frame in 
+// static storage, on the stack, or inside another struct. A zeroed frame is a valid empty frame,
+// so a static one doesn't need to be initialized. Slabs that have never been used are handed out
+// in order by bumping _unused_, and freed slabs go on a linked list like Frame's.
+//
+// _type_ has to be a single identifier since it gets pasted into names (typedef it first if not).
+// FRAME_DECLARE(double, 64) declares:
+// |	double_frame									the frame type
+// |	double* double_frame_alloc_raw(double_frame*)	NULL when the frame is full
+// |	double* double_frame_alloc(const double*, double_frame*)
+// |	void double_frame_free(double*, double_frame*)	does nothing for NULL
+// |	uint32_t double_frame_count_available(const double_frame*)
+//
+// FRAME_DECLARE(double, 64)
+// static double_frame frame;
+// double* p_a = double_frame_alloc_raw(&frame);
+// double_frame_free(p_a, &frame);
+//
+// SlabFrame.hpp has the same thing as a C++ template.
+
+#define FRAME_DECLARE(type, count)																	\
+																									\
+typedef union type##_frame_slab {																	\
+	type value;																						\
+	union type##_frame_slab* p_next;		/* next available slab while the slab is free */		\
+}type##_frame_slab;																					\
+																									\
+typedef struct {																					\
+	type##_frame_slab slabs[count];			/* the slabs themselves, no malloc */					\
+	type##_frame_slab* p_available;			/* freed slabs. NULL if there are none */				\
+	uint32_t unused;						/* slabs at this index and up have never been used */	\
+}type##_frame;																						\
+																									\
+static inline type* type##_frame_alloc_raw(type##_frame* p_frame) {									\
+	type##_frame_slab* p_slab = p_frame->p_available;												\
+	if (p_slab != NULL) {																			\
+		p_frame->p_available = p_slab->p_next;														\
+		return &p_slab->value;																		\
+	}																								\
+	if (p_frame->unused < (count)) {																\
+		return &p_frame->slabs[p_frame->unused++].value;											\
+	}																								\
+	return NULL;																					\
+}																									\
+																									\
+static inline type* type##_frame_alloc(const type* data, type##_frame* p_frame) {					\
+	type* p_slab = type##_frame_alloc_raw(p_frame);													\
+	if (p_slab != NULL) {																			\
+		*p_slab = *data;																			\
+	}																								\
+	return p_slab;																					\
+}																									\
+																									\
+static inline void type##_frame_free(type* p_location, type##_frame* p_frame) {						\
+	if (p_location == NULL) { return; }																\
+	assert((type##_frame_slab*)p_location >= p_frame->slabs											\
+		&& (type##_frame_slab*)p_location < p_frame->slabs + p_frame->unused);						\
+	type##_frame_slab* p_slab = (type##_frame_slab*)p_location;										\
+	p_slab->p_next = p_frame->p_available;															\
+	p_frame->p_available = p_slab;																	\
+}																									\
+																									\
+static inline uint32_t type##_frame_count_available(const type##_frame* p_frame) {					\
+	uint32_t available = (count) - p_frame->unused;													\
+	for (const type##_frame_slab* p_slab = p_frame->p_available; p_slab != NULL; p_slab = p_slab->p_next) {	\
+		available++;																				\
+	}																								\
+	return available;																				\
+}
+
+#endif
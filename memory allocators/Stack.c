@@ -0,0 +1,143 @@
+#include "Stack.h"
+
+// allocations are rounded up to this so headers stay pointer aligned
+#define STACK_ALIGNMENT sizeof(void*)
+
+static size_t stack_round_size(const size_t alloc_size) {
+	return (alloc_size + STACK_ALIGNMENT - 1) & ~(STACK_ALIGNMENT - 1);
+}
+
+// returns the chunk the next allocation should bump from
+static Pool* stack_top_chunk(Stack* p_stack) {
+	if (p_stack->p_top == NULL) {
+		return &p_stack->pool;
+	}
+	return p_stack->p_top->p_chunk;
+}
+
+// Pool's pool_has_capacity and pool_bump are inline only inside Pool.c, so the stack keeps its own copies
+static int stack_chunk_has_room(const size_t alloc_size, const Pool* p_chunk) {
+	size_t used = (char*)p_chunk->p_current - (char*)p_chunk->p_start;
+	return p_chunk->size >= used + alloc_size;
+}
+
+// creates the first chunk of the stack with _size_ bytes (headers included)
+// returns STACK_FAILURE if it can't be allocated
+STACK_RESULT stack_create(const size_t size, Stack* p_stack) {
+	if (size == 0 || p_stack == NULL) {
+		return STACK_INVALID_INPUT;
+	}
+
+	Pool new_pool = pool_create(size);
+	if (new_pool.p_start == NULL) {
+		return STACK_FAILURE;
+	}
+
+	memcpy(&p_stack->pool, &new_pool, sizeof(Pool));	// size is const, so no normal assignment
+	p_stack->p_top = NULL;
+
+	return STACK_SUCCESS;
+}
+
+// allocates _alloc_size_ bytes on top of the stack
+// moves on to the next chunk in the chain (allocating it if there isn't one) when the top chunk is full.
+// Chunks after the top chunk are always empty, so it never has to search the chain like pool_find_capacity
+// returns NULL on failure
+void* stack_alloc_raw(const size_t alloc_size, Stack* p_stack) {
+	if (p_stack == NULL || p_stack->pool.p_start == NULL) {
+		return NULL;
+	}
+
+	const size_t total_size = sizeof(StackHeader) + stack_round_size(alloc_size);
+	Pool* p_chunk = stack_top_chunk(p_stack);
+
+	while (!stack_chunk_has_room(total_size, p_chunk)) {
+		if (p_chunk->p_next == NULL && pool_realloc(total_size, p_chunk) == NULL) {
+			return NULL;
+		}
+		p_chunk = (Pool*)p_chunk->p_next;
+	}
+
+	StackHeader* p_header = p_chunk->p_current;
+	p_header->p_chunk = p_chunk;
+	p_header->p_prev = p_stack->p_top;
+#if STACK_DEBUG
+	p_header->canary = STACK_CANARY;
+	p_header->size = (uint32_t)alloc_size;
+#endif
+
+	p_chunk->p_current = (char*)p_chunk->p_current + total_size;
+	p_stack->p_top = p_header;
+
+	return p_header + 1;
+}
+
+void* stack_alloc(const void* data, const size_t alloc_size, Stack* p_stack) {
+	if (data == NULL) {
+		return NULL;
+	}
+
+	void* result = stack_alloc_raw(alloc_size, p_stack);
+	if (result == NULL) {
+		return NULL;
+	}
+
+	memcpy(result, data, alloc_size);
+	return result;
+}
+
+// returns the most recent allocation, or NULL if the stack is empty
+void* stack_top(const Stack* p_stack) {
+	if (p_stack == NULL || p_stack->p_top == NULL) {
+		return NULL;
+	}
+	return p_stack->p_top + 1;
+}
+
+// frees the most recent allocation
+// its chunk's p_current goes back to where the allocation started, and the previous 
+// allocation (possibly in an earlier chunk) becomes the top
+STACK_RESULT stack_pop(Stack* p_stack) {
+	if (p_stack == NULL || p_stack->p_top == NULL) {
+		return STACK_INVALID_INPUT;
+	}
+
+	StackHeader* p_header = p_stack->p_top;
+#if STACK_DEBUG
+	assert(p_header->canary == STACK_CANARY);	// header was overwritten
+	memset(p_header + 1, STACK_POISON, p_header->size);
+	p_header->canary = 0;
+#endif
+
+	p_header->p_chunk->p_current = p_header;
+	p_stack->p_top = p_header->p_prev;
+
+	return STACK_SUCCESS;
+}
+
+// frees _p_location_, which has to be the most recent allocation
+// returns STACK_OUT_OF_ORDER (and asserts with STACK_DEBUG) if it isn't, without freeing anything
+STACK_RESULT stack_free_last(void* p_location, Stack* p_stack) {
+	if (p_stack == NULL || p_location == NULL) {
+		return STACK_INVALID_INPUT;
+	}
+
+	if (p_location != stack_top(p_stack)) {
+#if STACK_DEBUG
+		assert(!"stack_free_last: freed out of LIFO order");
+#endif
+		return STACK_OUT_OF_ORDER;
+	}
+
+	return stack_pop(p_stack);
+}
+
+// frees every chunk of the stack
+void stack_free(Stack* p_stack) {
+	if (p_stack == NULL) {
+		return;
+	}
+
+	pool_free(&p_stack->pool);
+	p_stack->p_top = NULL;
+}
@@ -0,0 +1,79 @@
+#ifndef STACK_H
+#define STACK_H
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <assert.h>
+#include <stdint.h>
+
+#include "Pool.h"
+
+// This is a stack allocator built on top of a pool's chunk chain. It bumps just like a pool, but
+// since a lot of code (recursive parsers, DFS, evaluation stacks) allocates and frees in strict 
+// LIFO order, the most recent allocation can be given back with stack_pop/stack_free_last 
+// instead of holding everything until stack_free.
+//
+// Every allocation gets a small header in front of it that records which chunk it lives in and
+// where the previous allocation's header is. Popping moves that chunk's p_current back to the 
+// header, then makes the previous allocation the top, which might be in an earlier chunk. Chunks
+// that end up empty are kept attached for the next time the stack grows into them.
+//
+// Stack stack;
+// stack_create(sizeof(double) * 64, &stack);
+// double* p_a = stack_alloc_raw(sizeof(double), &stack);
+// double* p_b = stack_alloc_raw(sizeof(double), &stack);
+// stack_free_last(p_b, &stack);
+// stack_free_last(p_a, &stack);
+// stack_free(&stack);
+//
+// STACK_DEBUG (on by default in debug builds) adds a canary to each header, asserts when
+// stack_free_last is handed something that isn't the top allocation, and fills popped memory with
+// STACK_POISON so reads through stale pointers stand out.
+
+#ifndef STACK_DEBUG
+#ifndef NDEBUG
+#define STACK_DEBUG 1
+#else
+#define STACK_DEBUG 0
+#endif
+#endif
+
+#define STACK_CANARY 0x5374616bu
+#define STACK_POISON 0xDD
+
+typedef int STACK_RESULT;
+enum {
+	STACK_FAILURE,
+	STACK_SUCCESS,
+	STACK_INVALID_INPUT,
+	STACK_OUT_OF_ORDER			// tried to free something that isn't the top allocation
+};
+
+typedef struct StackHeader {
+	Pool* p_chunk;					// chunk this allocation lives in
+	struct StackHeader* p_prev;		// header of the allocation below this one. NULL at the bottom
+#if STACK_DEBUG
+	uint32_t canary;				// STACK_CANARY while the allocation is live
+	uint32_t size;					// size asked for, for poisoning on pop
+#endif
+}StackHeader;
+
+typedef struct {
+	Pool pool;						// first chunk, more are chained off pool.p_next
+	StackHeader* p_top;				// header of the most recent allocation. NULL if empty
+}Stack;
+
+STACK_RESULT stack_create(const size_t size, Stack* p_stack);
+
+void* stack_alloc_raw(const size_t alloc_size, Stack* p_stack);
+void* stack_alloc(const void* data, const size_t alloc_size, Stack* p_stack);
+
+void* stack_top(const Stack* p_stack);
+
+STACK_RESULT stack_pop(Stack* p_stack);
+STACK_RESULT stack_free_last(void* p_location, Stack* p_stack);
+
+void stack_free(Stack* p_stack);
+
+#endif
@@ -1,6 +1,18 @@
 #include "Pool.h"
+#include "Pool_p.h"
 #include "Slab.h"
 #include "Slab_s.h"
+#include "Slab_t.h"
+#include "Epoch.h"
+#include "Refill.h"
+#include "Buddy.h"
+#include "Scratch.h"
+#include "Stack.h"
+
+#include <time.h>
+
+// in testing_slab_frame.cpp, since SlabFrame.hpp is C++
+void test_slab_frame();
 
 
 void test_pool_create() {
@@ -191,8 +203,711 @@ void test_slab_multithreaded() {
 }
 
 
+// takes its own scratch pool while its caller's scratch pool (p_out) is live
+int* scratch_squares(const int count, Pool* p_out) {
+	Scratch scratch = scratch_begin(&p_out, 1);
+	assert(scratch.p_pool != NULL && scratch.p_pool != p_out);
+
+	int* p_temp = scratch_alloc_raw(sizeof(int) * count, &scratch);
+	for (int i = 0; i < count; ++i) {
+		p_temp[i] = i * i;
+	}
+
+	int* p_result = pool_alloc(p_temp, sizeof(int) * count, p_out);
+	scratch_end(&scratch);
+
+	return p_result;
+}
+
+void test_scratch() {
+	Scratch outer = scratch_begin(NULL, 0);
+	if (outer.p_pool == NULL) {
+		printf("failed to get a scratch pool\n");
+		exit(1);
+	}
+	void* p_outer_start = outer.p_pool->p_current;
+
+	double* p_a = scratch_alloc_raw(sizeof(double), &outer);
+	*p_a = 1.0;
+
+	printf("testing nested scopes: \n");
+	Scratch inner = scratch_begin(NULL, 0);
+	printf("inner scope uses the same pool: %s\n", inner.p_pool == outer.p_pool ? "yes" : "no");
+	void* p_inner_mark = inner.p_pool->p_current;
+	scratch_alloc_raw(1000, &inner);
+	scratch_end(&inner);
+	printf("inner scope released: %s\n", outer.p_pool->p_current == p_inner_mark ? "yes" : "no");
+	printf("outer allocation untouched: %lf\n", *p_a);
+
+	printf("\ntesting conflicts: \n");
+	int* p_squares = scratch_squares(10, outer.p_pool);
+	printf("squares[9] from the caller's scratch pool: %d\n", p_squares[9]);
+
+	printf("\ntesting spilling into new chunks: \n");
+	for (int i = 0; i < 10; ++i) {
+		scratch_alloc_raw(SCRATCH_POOL_SIZE / 4, &outer);
+	}
+	pool_print(outer.p_pool);
+	scratch_end(&outer);
+	printf("outer scope released: %s\n", outer.p_pool == NULL ? "yes" : "no");
+
+	Scratch again = scratch_begin(NULL, 0);
+	printf("pool is back at the start: %s\n", again.p_pool->p_current == p_outer_start ? "yes" : "no");
+
+	printf("\ntesting chunks are reused: \n");
+	int chunks_before = 0;
+	for (Pool* p_chunk = again.p_pool; p_chunk != NULL; p_chunk = (Pool*)p_chunk->p_next) {
+		chunks_before++;
+	}
+	for (int i = 0; i < 10; ++i) {
+		scratch_alloc_raw(SCRATCH_POOL_SIZE / 4, &again);
+	}
+	int chunks_after = 0;
+	for (Pool* p_chunk = again.p_pool; p_chunk != NULL; p_chunk = (Pool*)p_chunk->p_next) {
+		chunks_after++;
+	}
+	printf("no new chunks: %s (%d chunks)\n", chunks_before == chunks_after ? "yes" : "no", chunks_after);
+	scratch_end(&again);
+	again = scratch_begin(NULL, 0);
+
+	printf("\ntesting a scope that starts in a later chunk: \n");
+	scratch_alloc_raw(again.p_pool->size - 1000, &again);
+	scratch_alloc_raw(2000, &again);	// doesn't fit, so it goes in the second chunk
+	void* p_first_current = again.p_pool->p_current;
+
+	Scratch late = scratch_begin(NULL, 0);
+	Pool* p_late_chunk = late.p_chunk;
+	void* p_late_mark = late.p_mark;
+	scratch_alloc_raw(500, &late);		// would fit in the first chunk, but that's before the mark
+	scratch_end(&late);
+	printf("first chunk untouched: %s\n", again.p_pool->p_current == p_first_current ? "yes" : "no");
+	printf("second chunk back at the mark: %s\n", p_late_chunk != again.p_pool && p_late_chunk->p_current == p_late_mark ? "yes" : "no");
+	scratch_end(&again);
+
+	scratch_thread_free();
+}
+
+
+void test_stack() {
+	Stack stack;
+	// room for exactly two doubles in the first chunk
+	if (stack_create(2 * (sizeof(StackHeader) + sizeof(double)), &stack) != STACK_SUCCESS) {
+		printf("failed to create a stack\n");
+		exit(1);
+	}
+
+	double a = 1.0;
+	double* p_a = stack_alloc(&a, sizeof(double), &stack);
+	double* p_b = stack_alloc_raw(sizeof(double), &stack);
+	*p_b = 2.0;
+
+	printf("testing spilling into a new chunk: \n");
+	double* p_c = stack_alloc_raw(sizeof(double) * 8, &stack);
+	printf("b is in the first chunk: %s\n", ((StackHeader*)p_b - 1)->p_chunk == &stack.pool ? "yes" : "no");
+	printf("c is in the second chunk: %s\n", stack.p_top->p_chunk != &stack.pool ? "yes" : "no");
+
+	printf("\ntesting popping back into the first chunk: \n");
+	stack_free_last(p_c, &stack);
+	printf("top is b again: %s (%lf)\n", stack_top(&stack) == p_b ? "yes" : "no", *p_b);
+
+	double* p_d = stack_alloc_raw(sizeof(double), &stack);
+	printf("d reuses the second chunk: %s\n", (void*)p_d == (void*)p_c ? "yes" : "no");
+	stack_pop(&stack);
+
+	stack_free_last(p_b, &stack);
+	printf("a is the top: %s (%lf)\n", stack_top(&stack) == p_a ? "yes" : "no", *p_a);
+	stack_pop(&stack);
+	printf("stack is empty: %s\n", stack_top(&stack) == NULL ? "yes" : "no");
+	pool_print(&stack.pool);
+
+	stack_free(&stack);
+}
+
+
+void test_buddy() {
+	Buddy buddy;
+	if (buddy_region_create(4096, &buddy) != BUDDY_SUCCESS) {
+		printf("failed to create a buddy region\n");
+		exit(1);
+	}
+
+	printf("testing variable size allocations: \n");
+	void* p_a = buddy_alloc(20, &buddy);
+	void* p_b = buddy_alloc(100, &buddy);
+	void* p_c = buddy_alloc(1000, &buddy);
+	printf("block sizes: %zu %zu %zu\n", buddy_block_size(p_a, &buddy), buddy_block_size(p_b, &buddy), buddy_block_size(p_c, &buddy));
+	printf("free bytes: %zu\n", buddy_free_bytes(&buddy));
+
+	printf("\ntesting coalescing: \n");
+	buddy_free(p_b, &buddy);
+	buddy_free(p_a, &buddy);
+	buddy_free(p_c, &buddy);
+	printf("free bytes: %zu (expected: %zu)\n", buddy_free_bytes(&buddy), buddy.size);
+	void* p_whole = buddy_alloc(4096, &buddy);
+	printf("whole region allocates again: %s\n", p_whole == buddy.p_start ? "yes" : "no");
+	buddy_free(p_whole, &buddy);
+
+	printf("\ntesting as a chunk source: \n");
+	Pool pool = pool_create_source(200, &buddy.source);
+	for (int i = 0; i < 10; ++i) {
+		pool_raw_alloc(100, &pool);
+	}
+	Frame frame;
+	frame_create_source(sizeof(double), 16, FRAME_LAYOUT_PACKED, &buddy.source, &frame);
+	void* p_old_frame = frame.start;
+	printf("free bytes with a pool and frame: %zu\n", buddy_free_bytes(&buddy));
+
+	frame_free(&frame);
+	frame_create_source(sizeof(double), 16, FRAME_LAYOUT_PACKED, &buddy.source, &frame);
+	printf("new frame reuses the old chunk: %s\n", frame.start == p_old_frame ? "yes" : "no");
+	frame_free(&frame);
+	pool_free(&pool);
+	printf("free bytes after freeing: %zu (expected: %zu)\n", buddy_free_bytes(&buddy), buddy.size);
+
+	buddy_region_free(&buddy);
+}
+
+
+FRAME_DECLARE(double, 4)
+
+static double_frame typed_frame;	// static storage, zeroed, so it's ready to use
+
+void test_typed_frame() {
+	printf("slab size: %zu, frame size: %zu\n", sizeof(double_frame_slab), sizeof(double_frame));
+	printf("available slabs: %u\n", double_frame_count_available(&typed_frame));
+
+	double* p_slabs[4];
+	for (int i = 0; i < 4; ++i) {
+		double value = i + 0.5;
+		p_slabs[i] = double_frame_alloc(&value, &typed_frame);
+	}
+	printf("data at slab 3: %lf\n", *p_slabs[3]);
+
+	printf("\ntesting allocating beyond frame capacity: \n");
+	printf("full frame returns NULL: %s\n", double_frame_alloc_raw(&typed_frame) == NULL ? "yes" : "no");
+
+	printf("\ntesting free: \n");
+	double_frame_free(p_slabs[1], &typed_frame);
+	double_frame_free(NULL, &typed_frame);	// no-op, same as slab_free
+	printf("available slabs: %u\n", double_frame_count_available(&typed_frame));
+	double* p_reused = double_frame_alloc_raw(&typed_frame);
+	printf("freed slab is reused: %s\n", p_reused == p_slabs[1] ? "yes" : "no");
+}
+
+
+void test_from_buffer() {
+	printf("testing a pool on the stack that can't spill: \n");
+	char stack_buffer[4 * sizeof(double)];
+	Pool pool = pool_create_from_buffer(stack_buffer, sizeof(stack_buffer), POOL_SPILL_NEVER);
+	for (int i = 0; i < 4; ++i) {
+		pool_raw_alloc(sizeof(double), &pool);
+	}
+	printf("full pool returns NULL: %s\n", pool_raw_alloc(sizeof(double), &pool) == NULL ? "yes" : "no");
+	pool_free(&pool);	// must not free stack_buffer
+
+	printf("\ntesting a pool on the stack that can spill: \n");
+	Pool spill_pool = pool_create_from_buffer(stack_buffer, sizeof(stack_buffer), POOL_SPILL_ALLOWED);
+	for (int i = 0; i < 5; ++i) {
+		pool_raw_alloc(sizeof(double), &spill_pool);
+	}
+	printf("spilled into a malloc'd chunk: %s\n", spill_pool.p_next != NULL ? "yes" : "no");
+	pool_free(&spill_pool);	// frees the spilled chunk only
+
+	printf("\ntesting a frame in a static buffer: \n");
+	static char static_buffer[1024];
+	Frame frame;
+	if (frame_create_from_buffer(static_buffer, sizeof(static_buffer), sizeof(double), FRAME_LAYOUT_CACHE_ALIGNED, &frame) != SLAB_SUCCESS) {
+		printf("failed to create a frame from a buffer\n");
+		exit(1);
+	}
+	printf("slabs that fit: %u, available: %u\n", frame.slab_count, count_available_slabs(&frame));
+	frame_free(&frame);
+
+	printf("\ntesting a Frame_s inside another pool: \n");
+	Pool outer = pool_create(1024);
+	void* p_frame_memory = pool_raw_alloc(512, &outer);
+	Frame_s frame_s;
+	if (frame_s_create_from_buffer(p_frame_memory, 512, sizeof(double), FRAME_LAYOUT_PACKED, &frame_s) != SLAB_S_SUCCESS) {
+		printf("failed to create a Frame_s from a buffer\n");
+		exit(1);
+	}
+	Slab_s slab;
+	slab.memory_size = sizeof(double);
+	slab_s_alloc_raw(&slab, &frame_s);
+	printf("slab is inside the pool: %s\n", (char*)slab.memory >= (char*)outer.p_start && (char*)slab.memory < (char*)outer.p_current ? "yes" : "no");
+	slab_s_free(&slab, &frame_s);
+	frame_s_free(&frame_s);
+
+	printf("\ntesting a frame and a pool in misaligned pool memory: \n");
+	pool_raw_alloc(3, &outer);	// pools don't align, so the next allocation is off by 3
+	void* p_misaligned = pool_raw_alloc(256, &outer);
+	Frame packed_frame;
+	if (frame_create_from_buffer(p_misaligned, 256, sizeof(double), FRAME_LAYOUT_PACKED, &packed_frame) != SLAB_SUCCESS) {
+		printf("failed to create a frame from a misaligned buffer\n");
+		exit(1);
+	}
+	double* p_double = slab_alloc_raw(&packed_frame);
+	*p_double = 1.5;
+	printf("first slab is aligned: %s\n", (uintptr_t)p_double % _Alignof(max_align_t) == 0 ? "yes" : "no");
+	printf("slabs that fit: %u (expected: %u)\n", packed_frame.slab_count, (unsigned)((256 - packed_frame.offset) / sizeof(double)));
+	frame_free(&packed_frame);
+
+	pool_raw_alloc(3, &outer);
+	Pool* p_inner = pool_heap_create_from_buffer(pool_raw_alloc(128, &outer), 128, POOL_SPILL_NEVER);
+	printf("pool struct is aligned: %s\n", p_inner != NULL && (uintptr_t)p_inner % _Alignof(max_align_t) == 0 ? "yes" : "no");
+	pool_heap_free(p_inner);
+
+	pool_free(&outer);
+}
+
+
+#define EPOCH_TEST_READERS 4
+#define EPOCH_TEST_WRITERS 2
+#define EPOCH_TEST_UPDATES 20000
+#define EPOCH_TEST_SLABS 512
+
+typedef struct {
+	uint64_t value;
+	uint64_t check;			// always ~value. a zeroed (freed) slab breaks this
+}EpochTestNode;
+
+Frame_s epoch_frame;
+Epoch epoch;
+_Atomic(EpochTestNode*) p_epoch_shared;
+atomic_int epoch_writers_done;
+atomic_int epoch_bad_reads;
+
+int epoch_reader(void* arg) {
+	(void)arg;
+	EpochThread* p_thread = epoch_thread_register(&epoch);
+
+	while (atomic_load(&epoch_writers_done) < EPOCH_TEST_WRITERS) {
+		epoch_enter(p_thread, &epoch);
+		EpochTestNode* p_node = atomic_load(&p_epoch_shared);
+		uint64_t value = p_node->value;
+		thrd_yield();	// give writers a chance to retire it while it's being read
+		if (p_node->check != ~value) {
+			atomic_fetch_add(&epoch_bad_reads, 1);
+		}
+		epoch_exit(p_thread);
+	}
+
+	epoch_thread_unregister(p_thread, &epoch);
+	return 0;
+}
+
+int epoch_writer(void* arg) {
+	(void)arg;
+	EpochThread* p_thread = epoch_thread_register(&epoch);
+
+	for (uint64_t i = 0; i < EPOCH_TEST_UPDATES; ++i) {
+		Slab_s slab;
+		slab.memory_size = sizeof(EpochTestNode);
+		while (slab_s_alloc_raw(&slab, &epoch_frame) != SLAB_S_SUCCESS) {
+			epoch_reclaim(p_thread, &epoch);	// frame is full of retired slabs
+			thrd_yield();
+		}
+
+		EpochTestNode* p_node = slab.memory;
+		p_node->value = i;
+		p_node->check = ~i;
+
+		epoch_enter(p_thread, &epoch);
+		Slab_s old;
+		old.memory = atomic_exchange(&p_epoch_shared, p_node);
+		old.memory_size = sizeof(EpochTestNode);
+		epoch_retire(&old, p_thread, &epoch);
+		epoch_exit(p_thread);
+	}
+
+	epoch_thread_unregister(p_thread, &epoch);
+	atomic_fetch_add(&epoch_writers_done, 1);
+	return 0;
+}
+
+void test_epoch() {
+	if (frame_s_create(sizeof(EpochTestNode), EPOCH_TEST_SLABS, &epoch_frame) != SLAB_S_SUCCESS
+		|| epoch_create(&epoch_frame, &epoch) != EPOCH_SUCCESS) {
+		printf("Failed to create frame\n");
+		return;
+	}
+
+	Slab_s first;
+	first.memory_size = sizeof(EpochTestNode);
+	slab_s_alloc_raw(&first, &epoch_frame);
+	((EpochTestNode*)first.memory)->value = 0;
+	((EpochTestNode*)first.memory)->check = ~(uint64_t)0;
+	atomic_store(&p_epoch_shared, first.memory);
+
+	thrd_t threads[EPOCH_TEST_READERS + EPOCH_TEST_WRITERS];
+	for (int i = 0; i < EPOCH_TEST_READERS; ++i) {
+		thrd_create(&threads[i], epoch_reader, NULL);
+	}
+	for (int i = 0; i < EPOCH_TEST_WRITERS; ++i) {
+		thrd_create(&threads[EPOCH_TEST_READERS + i], epoch_writer, NULL);
+	}
+	for (int i = 0; i < EPOCH_TEST_READERS + EPOCH_TEST_WRITERS; ++i) {
+		thrd_join(threads[i], NULL);
+	}
+
+	printf("reads of freed slabs: %d (expected: 0)\n", atomic_load(&epoch_bad_reads));
+	printf("global epoch reached: %llu\n", (unsigned long long)atomic_load(&epoch.global_epoch));
+
+	Slab_s last;
+	last.memory = atomic_load(&p_epoch_shared);
+	last.memory_size = sizeof(EpochTestNode);
+	slab_s_free(&last, &epoch_frame);
+	epoch_free(&epoch);
+
+	uint32_t remaining = count_s_available_slabs(&epoch_frame);
+	printf("Available slabs after test: %u (expected: %u)\n", remaining, EPOCH_TEST_SLABS);
+
+	frame_s_free(&epoch_frame);
+}
+
+
+#define COMPACT_TEST_SLABS 4096
+static Slab_s compact_handles[COMPACT_TEST_SLABS];
+
+void test_frame_compaction() {
+	Frame_s frame;
+	if (frame_s_create(64, COMPACT_TEST_SLABS, &frame) != SLAB_S_SUCCESS
+		|| frame_s_track_handles(&frame) != SLAB_S_SUCCESS) {
+		printf("Failed to create frame\n");
+		return;
+	}
+
+	for (uint32_t i = 0; i < COMPACT_TEST_SLABS; ++i) {
+		compact_handles[i].memory_size = sizeof(uint32_t);
+		slab_s_alloc(&i, &compact_handles[i], &frame);
+	}
+
+	// keep every 10th one, spread over the whole frame
+	uint32_t live = 0;
+	for (uint32_t i = 0; i < COMPACT_TEST_SLABS; ++i) {
+		if (i % 10 == 0) {
+			live++;
+		}
+		else {
+			slab_s_free(&compact_handles[i], &frame);
+		}
+	}
+
+	FrameCompact_s compact;
+	frame_s_compact_begin(&compact, &frame);
+	int steps = 1;
+	while (frame_s_compact_step(64, &compact, &frame) == SLAB_S_IN_PROGRESS) {
+		steps++;
+	}
+
+	int bad = 0;
+	char* low_end = (char*)frame.start + frame.offset + (size_t)live * frame.slab_size;
+	for (uint32_t i = 0; i < COMPACT_TEST_SLABS; i += 10) {
+		if (*(uint32_t*)compact_handles[i].memory != i || (char*)compact_handles[i].memory >= low_end) {
+			bad++;
+		}
+	}
+
+	uint32_t released = frame_s_release_tail(&frame);
+
+	printf("moved %u of %u live slabs in %d steps\n", compact.moved, live, steps);
+	printf("bad handles: %d (expected: 0)\n", bad);
+	printf("released %u slots, %u left (expected: %u)\n", released, frame.slab_count, live);
+	printf("available after release: %u (expected: 0)\n", count_s_available_slabs(&frame));
+
+	frame_s_free(&frame);
+}
+
+// same thing, but the frame keeps being used between compaction steps
+#define COMPACT_LIVE_TEST_SLABS 64
+
+void test_frame_compaction_live() {
+	Frame_s frame;
+	if (frame_s_create(64, COMPACT_LIVE_TEST_SLABS, &frame) != SLAB_S_SUCCESS
+		|| frame_s_track_handles(&frame) != SLAB_S_SUCCESS) {
+		printf("Failed to create frame\n");
+		return;
+	}
+
+	for (uint32_t i = 0; i < COMPACT_LIVE_TEST_SLABS; ++i) {
+		compact_handles[i].memory_size = sizeof(uint32_t);
+		slab_s_alloc(&i, &compact_handles[i], &frame);
+	}
+	uint32_t live = 0;
+	for (uint32_t i = 0; i < COMPACT_LIVE_TEST_SLABS; ++i) {
+		if (i % 4 == 0) {
+			live++;
+		}
+		else {
+			slab_s_free(&compact_handles[i], &frame);
+		}
+	}
+
+	// new allocations reuse the handles of slabs freed above, tagged with their own index
+	uint32_t next = 1;
+	FrameCompact_s compact;
+	frame_s_compact_begin(&compact, &frame);
+	while (frame_s_compact_step(4, &compact, &frame) == SLAB_S_IN_PROGRESS) {
+		if (next < COMPACT_LIVE_TEST_SLABS) {
+			compact_handles[next].memory_size = sizeof(uint32_t);	// slab_s_free cleared it
+			if (slab_s_alloc(&next, &compact_handles[next], &frame) == SLAB_S_SUCCESS) {
+				live++;
+			}
+			next += next % 4 == 3 ? 2 : 1;
+		}
+	}
+
+	int bad = 0;
+	char* low_end = (char*)frame.start + frame.offset + (size_t)live * frame.slab_size;
+	for (uint32_t i = 0; i < COMPACT_LIVE_TEST_SLABS; ++i) {
+		if (compact_handles[i].memory == NULL) {
+			continue;
+		}
+		if (*(uint32_t*)compact_handles[i].memory != i || (char*)compact_handles[i].memory >= low_end) {
+			bad++;
+		}
+	}
+
+	uint32_t released = frame_s_release_tail(&frame);
+
+	printf("bad handles: %d (expected: 0)\n", bad);
+	printf("released %u slots (expected: %u)\n", released, COMPACT_LIVE_TEST_SLABS - live);
+
+	frame_s_free(&frame);
+}
+
+// seconds since some fixed point, for timing benchmarks
+double bench_seconds() {
+	struct timespec ts;
+	timespec_get(&ts, TIME_UTC);
+	return (double)ts.tv_sec + (double)ts.tv_nsec / 1e9;
+}
+
+#define LAYOUT_BENCH_THREADS 4
+#define LAYOUT_BENCH_UPDATES 20000000
+
+// each thread hammers its own slab. With a packed frame of 8 byte slabs, all of the
+// threads' slabs sit in the same cache line, so every write bounces that line between cores.
+int layout_bench_thread(void* arg) {
+	volatile uint64_t* p_counter = arg;
+
+	for (int i = 0; i < LAYOUT_BENCH_UPDATES; ++i) {
+		*p_counter += 1;
+	}
+
+	return 0;
+}
+
+void bench_frame_layout_run(const FRAME_LAYOUT layout, const char* name) {
+	Frame_s frame;
+	if (frame_s_create_layout(sizeof(uint64_t), LAYOUT_BENCH_THREADS, layout, &frame) != SLAB_S_SUCCESS) {
+		printf("Failed to create frame\n");
+		return;
+	}
+
+	Slab_s slabs[LAYOUT_BENCH_THREADS];
+	thrd_t threads[LAYOUT_BENCH_THREADS];
+
+	for (int i = 0; i < LAYOUT_BENCH_THREADS; ++i) {
+		slabs[i].memory_size = sizeof(uint64_t);
+		if (slab_s_alloc_raw(&slabs[i], &frame) != SLAB_S_SUCCESS) {
+			printf("Failed to allocate slab %d\n", i);
+			frame_s_free(&frame);
+			return;
+		}
+		*(uint64_t*)slabs[i].memory = 0;
+	}
+
+	double start = bench_seconds();
+	for (int i = 0; i < LAYOUT_BENCH_THREADS; ++i) {
+		thrd_create(&threads[i], layout_bench_thread, slabs[i].memory);
+	}
+	for (int i = 0; i < LAYOUT_BENCH_THREADS; ++i) {
+		thrd_join(threads[i], NULL);
+	}
+	double elapsed = bench_seconds() - start;
+
+	double updates = (double)LAYOUT_BENCH_THREADS * LAYOUT_BENCH_UPDATES;
+	printf("%-24s slab stride: %3zu  first slab offset: %3zu  %8.1f M updates/s\n",
+		name, frame.slab_size, frame.offset, updates / elapsed / 1e6);
+
+	frame_s_free(&frame);
+}
+
+void bench_frame_layout() {
+	bench_frame_layout_run(FRAME_LAYOUT_PACKED, "packed");
+	bench_frame_layout_run(FRAME_LAYOUT_CACHE_ALIGNED, "cache aligned");
+	bench_frame_layout_run(FRAME_LAYOUT_CACHE_ALIGNED | FRAME_LAYOUT_COLORED, "cache aligned + colored");
+}
+
+
+typedef struct {
+	POOL_P_REL next;		// self relative, so the list survives being mapped somewhere else
+	int64_t value;
+	double payload[2];
+}PersistentNode;
+
+// builds a list of _count_ nodes in _p_pool_ and makes the first one the root
+// the pool can grow (and move) during any allocation, so the previous node is tracked by offset
+void persistent_list_build(const int count, Pool_p* p_pool) {
+	uint64_t previous = 0;
+
+	for (int i = 0; i < count; ++i) {
+		PersistentNode* p_node = pool_p_raw_alloc(sizeof(PersistentNode), p_pool);
+		p_node->next = 0;
+		p_node->value = i;
+		p_node->payload[0] = i * 0.5;
+		p_node->payload[1] = i * 0.25;
+
+		if (previous == 0) {
+			pool_p_set_root(p_node, p_pool);
+		}
+		else {
+			PersistentNode* p_previous = pool_p_pointer(previous, p_pool);
+			pool_p_rel_set(&p_previous->next, p_node);
+		}
+		previous = pool_p_offset(p_node, p_pool);
+	}
+}
+
+int64_t persistent_list_sum(const PersistentNode* p_node) {
+	int64_t sum = 0;
+	for (; p_node != NULL; p_node = pool_p_rel_get(&p_node->next)) {
+		sum += p_node->value;
+	}
+	return sum;
+}
+
+void test_pool_p() {
+	const char* path = "pool_p_test.bin";
+	remove(path);
+
+	printf("testing creating a persistent pool: \n");
+	Pool_p pool;
+	if (pool_p_open(path, 256, &pool) != POOL_P_CREATED) {
+		printf("failed to create a persistent pool\n");
+		exit(1);
+	}
+	persistent_list_build(1000, &pool);	// grows the file several times
+	printf("file size after growing: %llu\n", (unsigned long long)pool.p_header->size);
+	printf("sum: %lld\n", (long long)persistent_list_sum(pool_p_get_root(&pool)));
+	pool_p_close(&pool);
+
+	printf("\ntesting re-opening it: \n");
+	POOL_P_RESULT result = pool_p_open(path, 256, &pool);
+	printf("mapped the old pool back in: %s\n", result == POOL_P_SUCCESS ? "yes" : "no");
+	printf("sum: %lld (expected: %d)\n", (long long)persistent_list_sum(pool_p_get_root(&pool)), 999 * 1000 / 2);
+	pool_p_close(&pool);
+
+	printf("\ntesting a file that isn't a pool: \n");
+	FILE* p_file = fopen(path, "wb");
+	fputs("definitely not a pool, but long enough to have a header's worth of bytes", p_file);
+	fclose(p_file);
+	printf("rejected: %s\n", pool_p_open(path, 256, &pool) == POOL_P_BAD_FILE ? "yes" : "no");
+
+	remove(path);
+}
+
+#define POOL_P_BENCH_NODES 100000
+
+typedef struct RebuiltNode {
+	struct RebuiltNode* p_next;
+	int64_t value;
+	double payload[2];
+}RebuiltNode;
+
+// the old way: build the whole list again in a Pool, object by object
+void bench_pool_p() {
+	const char* path = "pool_p_bench.bin";
+	remove(path);
+
+	double start = bench_seconds();
+	Pool pool = pool_create(POOL_SIZE_CAP);
+	RebuiltNode* p_head = NULL;
+	RebuiltNode* p_tail = NULL;
+	for (int i = 0; i < POOL_P_BENCH_NODES; ++i) {
+		RebuiltNode* p_node = pool_raw_alloc(sizeof(RebuiltNode), &pool);
+		p_node->p_next = NULL;
+		p_node->value = i;
+		p_node->payload[0] = i * 0.5;
+		p_node->payload[1] = i * 0.25;
+		if (p_tail == NULL) { p_head = p_node; }
+		else { p_tail->p_next = p_node; }
+		p_tail = p_node;
+	}
+	int64_t rebuilt_sum = 0;
+	for (RebuiltNode* p_node = p_head; p_node != NULL; p_node = p_node->p_next) {
+		rebuilt_sum += p_node->value;
+	}
+	double rebuild_time = bench_seconds() - start;
+	pool_free(&pool);
+
+	Pool_p persistent;
+	pool_p_open(path, sizeof(PersistentNode) * POOL_P_BENCH_NODES, &persistent);
+	persistent_list_build(POOL_P_BENCH_NODES, &persistent);
+	pool_p_close(&persistent);
+
+	start = bench_seconds();
+	pool_p_open(path, 0, &persistent);
+	int64_t loaded_sum = persistent_list_sum(pool_p_get_root(&persistent));
+	double load_time = bench_seconds() - start;
+	pool_p_close(&persistent);
+
+	printf("%d nodes\n", POOL_P_BENCH_NODES);
+	printf("rebuild in a Pool:     %8.3f ms (sum %lld)\n", rebuild_time * 1000, (long long)rebuilt_sum);
+	printf("re-map a Pool_p file:  %8.3f ms (sum %lld)\n", load_time * 1000, (long long)loaded_sum);
+
+	remove(path);
+}
+
+
+#define REFILL_BENCH_ALLOCS 20000
+#define REFILL_BENCH_ALLOC_SIZE 256
+
+// allocates from _p_pool_ with a bit of fake work in between, and reports the slowest allocations
+void bench_refill_run(Pool* p_pool, const char* name) {
+	double worst = 0.0;
+	double total = 0.0;
+	int slow = 0;
+	volatile unsigned int work = 0;
+
+	for (int i = 0; i < REFILL_BENCH_ALLOCS; ++i) {
+		double start = bench_seconds();
+		char* p_memory = pool_raw_alloc(REFILL_BENCH_ALLOC_SIZE, p_pool);
+		double elapsed = bench_seconds() - start;
+
+		p_memory[0] = 1;
+		total += elapsed;
+		if (elapsed > worst) { worst = elapsed; }
+		if (elapsed > 20e-6) { slow++; }
+
+		for (unsigned int j = 0; j < 2000; ++j) { work += j; }	// the rest of the request
+	}
+
+	printf("%-14s avg: %6.3f us  worst: %8.3f us  allocations over 20us: %d\n",
+		name, total / REFILL_BENCH_ALLOCS * 1e6, worst * 1e6, slow);
+}
+
+void bench_refill() {
+	Pool pool = pool_create(POOL_SIZE_CAP);
+	bench_refill_run(&pool, "inline malloc");
+	pool_free(&pool);
+
+	Refill refill;
+	if (refill_create(sizeof(Pool) + POOL_SIZE_CAP, NULL, &refill) != REFILL_SUCCESS) {
+		printf("failed to start a refill thread\n");
+		return;
+	}
+	Pool refilled_pool = pool_create_source(POOL_SIZE_CAP, &refill.source);
+	bench_refill_run(&refilled_pool, "refill thread");
+	printf("ready chunks taken: %zu, fell back to malloc: %zu\n", atomic_load(&refill.hits), atomic_load(&refill.misses));
+	pool_free(&refilled_pool);
+	refill_free(&refill);
+}
+
+
 void run_tests() {
-	switch (5) {
+	switch (18) {
 	case 1:
 		test_pool_create();
 		break;
@@ -208,6 +923,45 @@ void run_tests() {
 	case 5:
 		test_slab_multithreaded();
 		break;
+	case 6:
+		bench_frame_layout();
+		break;
+	case 7:
+		test_scratch();
+		break;
+	case 8:
+		test_stack();
+		break;
+	case 9:
+		test_buddy();
+		break;
+	case 10:
+		test_typed_frame();
+		break;
+	case 11:
+		test_from_buffer();
+		break;
+	case 12:
+		test_pool_p();
+		break;
+	case 13:
+		bench_pool_p();
+		break;
+	case 14:
+		test_epoch();
+		break;
+	case 15:
+		bench_refill();
+		break;
+	case 16:
+		test_frame_compaction();
+		break;
+	case 17:
+		test_frame_compaction_live();
+		break;
+	case 18:
+		test_slab_frame();
+		break;
 	default:
 		printf("no tests\n");
 	}
@@ -0,0 +1,47 @@
+// C++ tests for SlabFrame.hpp. The rest of the project is C, so this is the only thing that 
+// compiles the template. run_tests in testing.c calls test_slab_frame like any other test
+
+#include <cstdio>
+
+#include "SlabFrame.hpp"
+
+namespace {
+	int live_particles = 0;
+
+	struct Particle {
+		float x;
+		float y;
+
+		Particle(float x, float y) : x(x), y(y) { live_particles++; }
+		~Particle() { live_particles--; }
+	};
+
+	SlabFrame<Particle, 4> particles;
+}
+
+extern "C" void test_slab_frame() {
+	std::printf("slab size: %zu, frame size: %zu\n", particles.slab_size, sizeof(particles));
+	std::printf("available slabs: %u\n", particles.count_available());
+
+	Particle* p_slabs[4];
+	for (int i = 0; i < 4; ++i) {
+		p_slabs[i] = particles.alloc(i + 0.5f, -1.0f);
+	}
+	std::printf("data at slab 3: %f (constructed: %d)\n", p_slabs[3]->x, live_particles);
+
+	std::printf("\ntesting allocating beyond frame capacity: \n");
+	std::printf("full frame returns nullptr: %s\n", particles.alloc(0.0f, 0.0f) == nullptr ? "yes" : "no");
+
+	std::printf("\ntesting free: \n");
+	particles.free(p_slabs[1]);
+	particles.free(nullptr);	// no-op
+	std::printf("destructor ran: %s\n", live_particles == 3 ? "yes" : "no");
+	std::printf("available slabs: %u\n", particles.count_available());
+	Particle* p_reused = particles.alloc(9.0f, 9.0f);
+	std::printf("freed slab is reused: %s\n", p_reused == p_slabs[1] ? "yes" : "no");
+
+	for (int i = 0; i < 4; ++i) {
+		particles.free(p_slabs[i]);
+	}
+	std::printf("all destroyed: %s\n", live_particles == 0 ? "yes" : "no");
+}